@@ -0,0 +1,638 @@
+/*
+ * CS447 P1 Benchmarks
+ * -------------------
+ * Description: Micro-benchmarks for the server's hot paths on synthetic catalogs.
+ *
+ *      Build and run with:
+ *           make bench
+ *           ./bench search [rows]   Substring filters: search_courses() against the PackedColumn matchers
+ *           ./bench layout [rows]   Full LIST scans and memory: vector<Course> against CourseTable, and the full LIST reply
+ *                                   rendered per request against CourseRecords slices
+ *           ./bench load [rows]     Loading a synthetic courses.db with 1..all cores, and its snapshot (1M and 10M rows by default)
+ *           ./bench eligible [rows] ELIGIBLE for a student with 50 courses: string comparisons against the PrerequisiteGraph,
+ *                                   and SHOW <code> prereqs on one long chain of prerequisites
+ *           ./bench parse [lines]   Parsing text commands, with heap allocations counted: find/erase/substr against parse_command()
+ *           ./bench arena [count]   A command's temporaries on every core, with heap allocations counted: global heap against RequestArena
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory_resource>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "command_parser.h"
+#include "course_records.h"
+#include "p1_helper.h"
+#include "packed_column.h"
+#include "prerequisite_graph.h"
+#include "request_arena.h"
+#include "response_cache.h"
+using namespace std;
+
+// Every heap allocation made by the process, so a benchmark can report how many its body made
+static atomic<size_t> allocations{0};
+
+void *operator new(size_t size)
+{
+  allocations.fetch_add(1, memory_order_relaxed);
+  if (void *memory = malloc(size != 0 ? size : 1))
+  {
+    return memory;
+  }
+  throw bad_alloc();
+}
+
+// GCC mistakes the free() of the replaced operator delete for a mismatch once it inlines both
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void *memory) noexcept
+{
+  free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+  free(memory);
+}
+#pragma GCC diagnostic pop
+
+// Deterministic pseudo-random numbers so every run benchmarks the same catalog
+static uint64_t rng_state = 88172645463325252ull;
+static uint32_t next_random()
+{
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 7;
+  rng_state ^= rng_state << 17;
+  return static_cast<uint32_t>(rng_state);
+}
+
+static const char *SUBJECTS[] = {"Computer Science", "Mathematics", "Physics", "History", "Geology", "Art", "Chemistry", "Biology", "Music", "English", "Political Science", "Economics"};
+static const char *PREFIXES[] = {"CS", "MATH", "PHYS", "HIST", "GEOL", "ART", "CHEM", "BIO", "MUSI", "ENGL", "POLS", "ECON"};
+static const char *NAMES[] = {"Professor Calculus", "Dr. Castafiore", "Mr. Cuthbert", "Ms. La Goulue", "Mr. Nestor", "Mr. Jolyon Wagg", "Dr. J. C. F. Feller", "Mr. Thompson", "Professor Tarragon", "Ms. Bianca Castafiore", "Dr. S. I. L. Vester", "Captain Haddock"};
+static const char *WORDS[] = {"introduction", "advanced", "theory", "systems", "analysis", "design", "modern", "applied", "principles", "methods", "structures", "fundamental", "concepts", "survey", "study", "topics", "practice", "computational", "historical", "experimental"};
+
+template <size_t N>
+static const char *pick(const char *(&list)[N])
+{
+  return list[next_random() % N];
+}
+
+static string random_words(int count)
+{
+  string text;
+  for (int i = 0; i < count; i++)
+  {
+    text += (i == 0 ? "" : " ");
+    text += pick(WORDS);
+  }
+  return text;
+}
+
+// The subject of the i-th synthetic course, fixed so that later rows can name it as a prerequisite
+static size_t synthetic_subject(size_t i)
+{
+  return (i * 2654435761u >> 7) % (sizeof SUBJECTS / sizeof SUBJECTS[0]);
+}
+
+static string synthetic_code(size_t i)
+{
+  return string(PREFIXES[synthetic_subject(i)]) + to_string(100000 + i);
+}
+
+// Fills in the i-th course of a synthetic catalog
+static void make_synthetic_course(size_t i, Course &course)
+{
+  size_t subject = synthetic_subject(i);
+  course.course_code = synthetic_code(i);
+  course.title = random_words(3);
+  course.subject = SUBJECTS[subject];
+  course.instructor = pick(NAMES);
+  course.prerequisites.clear();
+  if (i > 0 && next_random() % 2 == 0)
+  {
+    course.prerequisites.push_back(synthetic_code(next_random() % i));
+  }
+  course.capacity = 10 + next_random() % 40;
+  course.seats_available = next_random() % (course.capacity + 1);
+  course.description = random_words(12) + ".";
+}
+
+vector<Course> make_synthetic_courses(size_t rows)
+{
+  vector<Course> courses(rows);
+  for (size_t i = 0; i < rows; i++)
+  {
+    make_synthetic_course(i, courses[i]);
+  }
+  return courses;
+}
+
+// Writes a synthetic catalog in the courses.db format, one row at a time so huge files fit in memory
+static void write_synthetic_db(const string &filename, size_t rows)
+{
+  FILE *out = fopen(filename.c_str(), "w");
+  if (out == nullptr)
+  {
+    perror(filename.c_str());
+    exit(1);
+  }
+  fprintf(out, "Course Code; Title; Subject; Instructor; Prerequisites; Seats; Capacity; Description\n");
+  Course course;
+  for (size_t i = 0; i < rows; i++)
+  {
+    make_synthetic_course(i, course);
+    fprintf(out, "%s;%s;%s;%s;%s;%d;%d;%s\n", course.course_code.c_str(), course.title.c_str(), course.subject.c_str(), course.instructor.c_str(),
+            course.prerequisites.empty() ? "" : course.prerequisites[0].c_str(), course.seats_available, course.capacity, course.description.c_str());
+  }
+  fclose(out);
+}
+
+// Runs a benchmark body a few times and reports the fastest run
+static void measure(const char *name, const function<size_t()> &body, int runs = 5)
+{
+  double best = 1e30;
+  size_t result = 0;
+  for (int run = 0; run < runs; run++)
+  {
+    auto start = chrono::steady_clock::now();
+    result = body();
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    best = min(best, ms);
+  }
+  printf("  %-44s %10.2f ms  (%zu matches)\n", name, best, result);
+}
+
+static void bench_search(size_t rows)
+{
+  printf("building a synthetic catalog of %zu rows...\n", rows);
+  vector<Course> courses = make_synthetic_courses(rows);
+  PackedColumn codes, instructors, descriptions;
+  for (const Course &course : courses)
+  {
+    codes.add(course.course_code);
+    instructors.add(course.instructor);
+    descriptions.add(course.description);
+  }
+
+  const PackedColumn::Matcher matchers[] = {PackedColumn::Matcher::Scalar, PackedColumn::Matcher::SSE42, PackedColumn::Matcher::AVX2};
+  const char *matcherNames[] = {"scalar", "sse4.2", "avx2"};
+
+  struct Case
+  {
+    const char *filter;
+    const char *term;
+    const PackedColumn *column;
+  } cases[] = {
+      {"instructor", "Castafiore", &instructors},
+      {"course-code", "99999", &codes},
+      {"description", "systems analysis design", &descriptions},
+  };
+
+  for (const Case &c : cases)
+  {
+    printf("\n%s contains \"%s\"\n", c.filter, c.term);
+    if (strcmp(c.filter, "description") != 0)
+    {
+      measure("search_courses (copies every match)", [&]
+              { return search_courses(courses, c.filter, c.term).size(); });
+    }
+    else
+    {
+      // search_courses has no description filter; this is the same find() loop it would run
+      measure("std::string::find over vector<Course>", [&]
+              {
+                size_t matches = 0;
+                for (const Course &course : courses)
+                {
+                  matches += course.description.find(c.term) != string::npos;
+                }
+                return matches; });
+    }
+    for (int m = 0; m < 3; m++)
+    {
+      if (!PackedColumn::supported(matchers[m]))
+      {
+        printf("  PackedColumn %-31s %13s\n", matcherNames[m], "unsupported");
+        continue;
+      }
+      string name = string("PackedColumn ") + matcherNames[m];
+      measure(name.c_str(), [&]
+              { return c.column->find(c.term, matchers[m]).size(); });
+    }
+  }
+}
+
+// Heap bytes held by a string beyond the object itself (0 while it fits the small-string buffer)
+static size_t heap_bytes(const string &text)
+{
+  return text.capacity() > 15 ? text.capacity() + 1 : 0;
+}
+
+static void bench_layout(size_t rows)
+{
+  printf("building a synthetic catalog of %zu rows...\n", rows);
+  vector<Course> courses = make_synthetic_courses(rows);
+  CourseTable table = to_course_table(courses);
+
+  size_t vectorBytes = courses.capacity() * sizeof(Course);
+  for (const Course &course : courses)
+  {
+    vectorBytes += heap_bytes(course.course_code) + heap_bytes(course.title) + heap_bytes(course.subject) + heap_bytes(course.instructor) + heap_bytes(course.description);
+    vectorBytes += course.prerequisites.capacity() * sizeof(string);
+    for (const string &prereq : course.prerequisites)
+    {
+      vectorBytes += heap_bytes(prereq);
+    }
+  }
+  size_t tableBytes = table.arena_bytes() + table.string_count() * sizeof(uint32_t) + rows * (5 * sizeof(CourseTable::StringId) + 3 * sizeof(int32_t));
+  for (size_t row = 0; row < rows; row++)
+  {
+    tableBytes += table.prerequisite_count(row) * sizeof(CourseTable::StringId);
+  }
+  printf("\nmemory (approximate, excluding allocator overhead)\n");
+  printf("  %-44s %10.1f MiB\n", "vector<Course>", vectorBytes / 1048576.0);
+  printf("  %-44s %10.1f MiB  (%zu distinct strings)\n", "CourseTable", tableBytes / 1048576.0, table.string_count());
+
+  printf("\nfull LIST scan (code and title of every course)\n");
+  measure("vector<Course>", [&]
+          {
+            size_t bytes = 0;
+            for (const Course &course : courses)
+            {
+              bytes += course.course_code.size() + course.title.size();
+            }
+            return bytes; });
+  measure("CourseTable", [&]
+          {
+            size_t bytes = 0;
+            for (size_t row = 0; row < table.size(); row++)
+            {
+              bytes += table.course_code(row).size() + table.title(row).size();
+            }
+            return bytes; });
+
+  printf("\nfull LIST reply (queued for writev, not sent)\n");
+  CourseRecords records;
+  measure("CourseRecords::build (once per load)", [&]
+          {
+            records.build(table);
+            return records.bytes(); }, 3);
+  measure("stringstream per request", [&]
+          {
+            stringstream output;
+            output << "250 \n";
+            for (size_t row = 0; row < table.size(); row++)
+            {
+              output << table.course_code(row) << " " << table.title(row) << "\n";
+            }
+            OutputQueue out;
+            out.push(output.str());
+            out.push_static("\n");
+            return out.pending_bytes(); });
+  measure("CourseRecords slices", [&]
+          {
+            CachedResponse::Builder output;
+            output.append("250 \n");
+            for (size_t row = 0; row < table.size(); row++)
+            {
+              output.append_shared(records.arena(), records.list_line(row));
+            }
+            OutputQueue out;
+            output.finish()->send(out);
+            return out.pending_bytes(); });
+}
+
+static void bench_load(size_t rows)
+{
+  string filename = "/tmp/bench_courses_" + to_string(rows) + ".db";
+  printf("\nwriting a synthetic %zu row courses.db to %s...\n", rows, filename.c_str());
+  write_synthetic_db(filename, rows);
+
+  unsigned cores = max(1u, thread::hardware_concurrency());
+  vector<unsigned> thread_counts;
+  for (unsigned threads = 1; threads < cores; threads *= 2)
+  {
+    thread_counts.push_back(threads);
+  }
+  thread_counts.push_back(cores);
+  for (unsigned threads : thread_counts)
+  {
+    string name = "load_course_table, " + to_string(threads) + " thread(s)";
+    measure(name.c_str(), [&]
+            { return load_course_table(filename, threads).size(); }, 3);
+  }
+
+  // The same catalog as a binary snapshot, which is mapped and validated rather than parsed
+  string snapshot = "/tmp/bench_courses_" + to_string(rows) + ".snap";
+  string error;
+  if (!load_course_table(filename).write_snapshot(snapshot, error))
+  {
+    fprintf(stderr, "bench: %s: %s\n", snapshot.c_str(), error.c_str());
+    exit(1);
+  }
+  measure("CourseTable::open_snapshot", [&]
+          {
+            CourseTable table;
+            return table.open_snapshot(snapshot, error) ? table.size() : 0; }, 3);
+  remove(snapshot.c_str());
+  remove(filename.c_str());
+}
+
+static void bench_eligible(size_t rows)
+{
+  printf("building a synthetic catalog of %zu rows...\n", rows);
+  vector<Course> courses = make_synthetic_courses(rows);
+  CourseTable table = to_course_table(courses);
+  CourseIndex index = build_course_index(table);
+  PrerequisiteGraph graph;
+  vector<string> problems;
+  measure("PrerequisiteGraph::build", [&]
+          {
+            problems.clear();
+            graph.build(table, index, problems);
+            return graph.size(); }, 3);
+
+  // A student who has taken some early courses, so that a few of their successors open up
+  vector<string> enrollmentHistory;
+  for (int i = 0; i < 50; i++)
+  {
+    enrollmentHistory.push_back(courses[next_random() % min<size_t>(rows, 1000)].course_code);
+  }
+
+  printf("\nELIGIBLE (every course whose prerequisites are met and that is not taken yet)\n");
+  // What the ENROLL handler did before the graph, once per course in the catalog
+  measure("prerequisite strings against the history", [&]
+          {
+            size_t eligible = 0;
+            for (const Course &course : courses)
+            {
+              bool met = true;
+              for (const string &prereq : course.prerequisites)
+              {
+                bool found = false;
+                for (const string &taken : enrollmentHistory)
+                {
+                  if (prereq == taken)
+                  {
+                    found = true;
+                    break;
+                  }
+                }
+                met = met && found;
+              }
+              bool enrolled = false;
+              for (const string &taken : enrollmentHistory)
+              {
+                enrolled = enrolled || taken == course.course_code;
+              }
+              eligible += met && !enrolled;
+            }
+            return eligible; }, 3);
+  measure("PrerequisiteGraph bitset AND", [&]
+          {
+            CourseSet taken;
+            for (const string &code : enrollmentHistory)
+            {
+              taken.insert(find_course_slot(table, index, code));
+            }
+            return graph.eligible_courses(taken).size(); });
+
+  // One long line of prerequisites, where every course's chain holds every course before it
+  printf("\nSHOW <code> prereqs on a single chain of %zu courses\n", rows);
+  vector<Course> line = courses;
+  for (size_t i = 0; i < line.size(); i++)
+  {
+    line[i].prerequisites.assign(i == 0 ? 0 : 1, i == 0 ? string() : line[i - 1].course_code);
+  }
+  CourseTable lineTable = to_course_table(line);
+  CourseIndex lineIndex = build_course_index(lineTable);
+  PrerequisiteGraph lineGraph;
+  measure("PrerequisiteGraph::build", [&]
+          {
+            problems.clear();
+            lineGraph.build(lineTable, lineIndex, problems);
+            return lineGraph.size(); }, 3);
+  measure("chain of the last course", [&]
+          { return lineGraph.chain(lineGraph.size() - 1).size(); }, 3);
+}
+
+// The command recognition and argument extraction message_handler did before parse_command()
+static bool legacy_is_option(string command)
+{
+  return command == "HELP" || command == "CATALOG" || command == "ENROLLMENT" || command == "MYCOURSES" || command == "LIST" || command == "VIEWGRADES" || command == "ELIGIBLE" || command == "BINARY" || command == "BYE" || (command.find("LIST") != string::npos) || (command.find("SEARCH") != string::npos) || (command.find("SHOW") != string::npos) || (command.find("ENROLL") != string::npos) || (command.find("DROP") != string::npos);
+}
+
+static size_t legacy_parse(string message)
+{
+  if (!legacy_is_option(message))
+  {
+    return 0;
+  }
+  string filter, search_term;
+  if (message.find("SEARCH") != string::npos)
+  {
+    message.erase(0, message.find(" ") + 1);
+    filter = message.substr(0, message.find(" "));
+    message.erase(0, message.find(" ") + 1);
+    bool wordFilter = filter == "title" || filter == "description" || filter == "keyword";
+    search_term = wordFilter ? message : message.substr(0, message.find(" "));
+  }
+  else if (message.find("LIST") != string::npos)
+  {
+    filter = "ALL";
+    if (message.find(" ") != string::npos)
+    {
+      message.erase(0, message.find(" ") + 1);
+      filter = message.substr(0, message.find(" "));
+      message.erase(0, message.find(" ") + 1);
+      search_term = message.substr(0, message.find(" "));
+    }
+  }
+  else if (message.find("SHOW") != string::npos)
+  {
+    message.erase(0, message.find(" ") + 1);
+    filter = message.substr(0, message.find(" "));
+    if (message.find(" ") != string::npos)
+    {
+      message.erase(0, message.find(" ") + 1);
+      search_term = message;
+    }
+  }
+  else if (message.find("ENROLL") != string::npos || message.find("DROP") != string::npos)
+  {
+    message.erase(0, message.find(" ") + 1);
+    filter = message;
+  }
+  return filter.size() + search_term.size() + 1;
+}
+
+// The same extraction with parse_command(), over string_views of the received line
+static size_t tokenized_parse(string_view message)
+{
+  Command command = parse_command(message);
+  string_view arguments = command.arguments;
+  string_view filter, search_term;
+  switch (command.verb)
+  {
+  case Verb::Unknown:
+    return 0;
+  case Verb::Search:
+    filter = next_word(arguments);
+    search_term = filter == "title" || filter == "description" || filter == "keyword" ? arguments : next_word(arguments);
+    break;
+  case Verb::List:
+    filter = "ALL";
+    if (!arguments.empty())
+    {
+      filter = next_word(arguments);
+      search_term = next_word(arguments);
+    }
+    break;
+  case Verb::Show:
+    filter = next_word(arguments);
+    search_term = arguments;
+    break;
+  case Verb::Enroll:
+  case Verb::Drop:
+    filter = arguments;
+    break;
+  default:
+    break;
+  }
+  return filter.size() + search_term.size() + 1;
+}
+
+static void bench_parse(size_t lines)
+{
+  // A session's worth of commands, long enough that copies of them leave the small-string buffer
+  const vector<string> commands = {"LIST", "LIST subject Computer Science", "SEARCH keyword introduction advanced theory", "SEARCH instructor Professor Calculus", "SHOW MATH201 availability", "SHOW CS101", "ENROLL PHYS1010", "DROP HIST2020", "ELIGIBLE", "CATALOG", "HELP", "BLISTER PACK OF COMMANDS"};
+  printf("parsing %zu command lines\n", lines);
+  for (int variant = 0; variant < 2; variant++)
+  {
+    const char *name = variant == 0 ? "find/erase/substr on string copies" : "parse_command over string_view";
+    size_t before = allocations.load(memory_order_relaxed);
+    measure(name, [&]
+            {
+              size_t total = 0;
+              for (size_t i = 0; i < lines; i++)
+              {
+                const string &line = commands[i % commands.size()];
+                total += variant == 0 ? legacy_parse(line) : tokenized_parse(line);
+              }
+              return total; }, 1);
+    size_t made = allocations.load(memory_order_relaxed) - before;
+    printf("  %-44s %10.2f allocations per command\n", "", static_cast<double>(made) / lines);
+  }
+}
+
+// The temporaries of an ENROLL or SEARCH: a cache key, a copy of the student's courses and a list of slots
+template <typename String, typename Strings, typename Slots>
+static size_t command_temporaries(const vector<string> &enrollments, String key, Strings courses, Slots slots)
+{
+  key.append("SEARCH\x1f").append("instructor").append("\x1f").append("Professor Calculus");
+  courses.assign(enrollments.begin(), enrollments.end());
+  for (uint32_t i = 0; i < 64; i++)
+  {
+    slots.push_back(i);
+  }
+  return key.size() + courses.size() + slots.size();
+}
+
+static void bench_arena(size_t commands)
+{
+  // Long enough course codes that the copies leave the small-string buffer
+  vector<string> enrollments;
+  for (int i = 0; i < 20; i++)
+  {
+    enrollments.push_back("COMPUTERSCIENCE" + to_string(1000 + i));
+  }
+  unsigned threads = max(1u, thread::hardware_concurrency());
+  printf("%zu commands' temporaries on each of %u thread(s)\n", commands, threads);
+  for (int variant = 0; variant < 2; variant++)
+  {
+    const char *name = variant == 0 ? "global heap" : "RequestArena, reset per command";
+    size_t before = allocations.load(memory_order_relaxed);
+    measure(name, [&]
+            {
+              vector<jthread> workers;
+              for (unsigned t = 0; t < threads; t++)
+              {
+                workers.emplace_back([&]
+                                     {
+                                       RequestArena arena;
+                                       size_t total = 0;
+                                       for (size_t i = 0; i < commands; i++)
+                                       {
+                                         if (variant == 0)
+                                         {
+                                           total += command_temporaries(enrollments, string(), vector<string>(), vector<uint32_t>());
+                                           continue;
+                                         }
+                                         RequestScope scope(arena);
+                                         total += command_temporaries(enrollments, pmr::string(arena.resource()), pmr::vector<pmr::string>(arena.resource()), pmr::vector<uint32_t>(arena.resource()));
+                                       } });
+              }
+              return commands * threads; }, 1);
+    size_t made = allocations.load(memory_order_relaxed) - before;
+    printf("  %-44s %10.2f allocations per command\n", "", static_cast<double>(made) / (commands * threads));
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc < 2)
+  {
+    fprintf(stderr, "usage: bench search|layout|load|eligible|parse|arena [rows]\n");
+    return 1;
+  }
+  string which = argv[1];
+  if (which == "search")
+  {
+    bench_search(argc > 2 ? strtoull(argv[2], nullptr, 10) : 1000000);
+    return 0;
+  }
+  if (which == "load")
+  {
+    // Both catalog sizes from the request unless one is given
+    vector<size_t> sizes = {1000000, 10000000};
+    if (argc > 2)
+    {
+      sizes = {strtoull(argv[2], nullptr, 10)};
+    }
+    for (size_t rows : sizes)
+    {
+      bench_load(rows);
+    }
+    return 0;
+  }
+  if (which == "eligible")
+  {
+    bench_eligible(argc > 2 ? strtoull(argv[2], nullptr, 10) : 1000000);
+    return 0;
+  }
+  if (which == "parse")
+  {
+    bench_parse(argc > 2 ? strtoull(argv[2], nullptr, 10) : 10000000);
+    return 0;
+  }
+  if (which == "arena")
+  {
+    bench_arena(argc > 2 ? strtoull(argv[2], nullptr, 10) : 1000000);
+    return 0;
+  }
+  if (which == "layout")
+  {
+    bench_layout(argc > 2 ? strtoull(argv[2], nullptr, 10) : 1000000);
+    return 0;
+  }
+  fprintf(stderr, "bench: unknown benchmark '%s'\n", argv[1]);
+  return 1;
+}
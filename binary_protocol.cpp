@@ -0,0 +1,103 @@
+/*
+ * BINARY PROTOCOL
+ * ---------------
+ * Description: Length-prefixed frames with big-endian fields, for clients that switch
+ *              from the text commands with BINARY.
+ */
+#include "binary_protocol.h"
+
+void FrameWriter::u16(uint16_t value)
+{
+    frame_.push_back(static_cast<char>(value >> 8));
+    frame_.push_back(static_cast<char>(value));
+}
+
+void FrameWriter::u32(uint32_t value)
+{
+    frame_.push_back(static_cast<char>(value >> 24));
+    frame_.push_back(static_cast<char>(value >> 16));
+    frame_.push_back(static_cast<char>(value >> 8));
+    frame_.push_back(static_cast<char>(value));
+}
+
+void FrameWriter::string(std::string_view text)
+{
+    text = text.substr(0, UINT16_MAX);
+    u16(static_cast<uint16_t>(text.size()));
+    frame_.append(text);
+}
+
+void FrameWriter::patch_u32(size_t position, uint32_t value)
+{
+    frame_[position] = static_cast<char>(value >> 24);
+    frame_[position + 1] = static_cast<char>(value >> 16);
+    frame_[position + 2] = static_cast<char>(value >> 8);
+    frame_[position + 3] = static_cast<char>(value);
+}
+
+std::string FrameWriter::finish(size_t following)
+{
+    patch_u32(0, static_cast<uint32_t>(frame_.size() - 4 + following));
+    std::string frame;
+    frame.swap(frame_);
+    frame_.assign(4, '\0');
+    return frame;
+}
+
+std::string FrameWriter::continuation()
+{
+    std::string part;
+    part.swap(frame_);
+    part.erase(0, 4);
+    frame_.assign(4, '\0');
+    return part;
+}
+
+bool FrameReader::u8(uint8_t &value)
+{
+    if (data_.size() < 1)
+    {
+        return false;
+    }
+    value = static_cast<uint8_t>(data_[0]);
+    data_.remove_prefix(1);
+    return true;
+}
+
+bool FrameReader::u16(uint16_t &value)
+{
+    if (data_.size() < 2)
+    {
+        return false;
+    }
+    value = static_cast<uint16_t>(static_cast<uint8_t>(data_[0]) << 8 | static_cast<uint8_t>(data_[1]));
+    data_.remove_prefix(2);
+    return true;
+}
+
+bool FrameReader::u32(uint32_t &value)
+{
+    if (data_.size() < 4)
+    {
+        return false;
+    }
+    value = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        value = value << 8 | static_cast<uint8_t>(data_[i]);
+    }
+    data_.remove_prefix(4);
+    return true;
+}
+
+bool FrameReader::string(std::string_view &text)
+{
+    uint16_t length;
+    if (!u16(length) || data_.size() < length)
+    {
+        return false;
+    }
+    text = data_.substr(0, length);
+    data_.remove_prefix(length);
+    return true;
+}
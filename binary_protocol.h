@@ -0,0 +1,128 @@
+#ifndef BINARY_PROTOCOL_H
+#define BINARY_PROTOCOL_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * The binary protocol, an alternative to the text commands for programs.
+ *
+ * A signed-in client switches with the text command BINARY. Once the server
+ * has replied "200 BINARY", every message in both directions is a frame: a
+ * uint32 length followed by that many bytes. The client must wait for that
+ * reply before sending its first frame. All integers are big-endian, and a
+ * string is a uint16 length followed by its bytes.
+ *
+ * Request frame:  uint8 opcode, then the opcode's string arguments.
+ * Response frame: uint16 status (the text protocol's reply codes), uint8 opcode,
+ *                 then a body. Every failure, and every success without data,
+ *                 has the reply's message as its body, unprefixed.
+ *
+ * Opcodes, with their arguments and successful bodies:
+ *   BYE                                  message; the server closes the connection
+ *   LIST [filter, term [, page]]         uint32 count, count course summaries
+ *   SEARCH filter, term [, page]         uint32 count, count course summaries
+ *   SHOW code                            one course record
+ *   AVAILABILITY code                    int32 seats available, int32 capacity
+ *   PREREQS code                         uint8 flags (1 = blocked by a cycle, 2 = incomplete),
+ *                                        uint32 count, count course code strings
+ *   ENROLL code, DROP code               message
+ *   MYCOURSES, ELIGIBLE                  uint32 count, count course code strings (MYCOURSES)
+ *                                        or course summaries (ELIGIBLE)
+ * There are no modes: the opcode says what is asked.
+ *
+ * A page is two uint32s after the strings: the page number, counted from 1
+ * or 0 for every result, and its size, 0 for the default of 50 and at most
+ * 1000. LIST without a filter sends two empty strings before it. A paged body
+ * starts with a uint32 total of results on every page, then the count and
+ * summaries of the page asked for. A page past the end is 304, and a size over
+ * 1000 is 400. Replies of more than 1024 courses without a page are streamed.
+ *
+ * A course summary is a fixed 12-byte header, int32 seats available, int32
+ * capacity, uint16 code length, uint16 title length, followed by the code and
+ * title bytes. A course record is a fixed 24-byte header, int32 seats
+ * available, int32 capacity, uint16 lengths of code, title, subject and
+ * instructor, uint16 prerequisite count, uint16 zero, uint32 description length,
+ * followed by those five strings' bytes and then the prerequisite code strings.
+ */
+enum class Opcode : uint8_t
+{
+    Bye = 1,
+    List = 2,
+    Search = 3,
+    Show = 4,
+    Availability = 5,
+    Prereqs = 6,
+    Enroll = 7,
+    Drop = 8,
+    MyCourses = 9,
+    Eligible = 10
+};
+
+/**
+ * @class FrameWriter
+ * @brief Builds one frame; the length prefix is filled in by finish().
+ */
+class FrameWriter
+{
+public:
+    FrameWriter() : frame_(4, '\0') {}
+
+    void u8(uint8_t value) { frame_.push_back(static_cast<char>(value)); }
+    void u16(uint16_t value);
+    void u32(uint32_t value);
+    void i32(int32_t value) { u32(static_cast<uint32_t>(value)); }
+
+    /**
+     * @brief Appends a uint16 length-prefixed string, cut to 65535 bytes.
+     */
+    void string(std::string_view text);
+
+    /**
+     * @brief Appends bytes with no length prefix.
+     */
+    void bytes(std::string_view data) { frame_.append(data); }
+
+    /**
+     * @brief The position of the next byte, for patch_u32().
+     */
+    size_t position() const { return frame_.size(); }
+    void patch_u32(size_t position, uint32_t value);
+
+    /**
+     * @brief The finished frame, length prefix included.
+     * @param following The bytes of the frame still to be sent after this part, counted in the length prefix.
+     */
+    std::string finish(size_t following = 0);
+
+    /**
+     * @brief The bytes written so far without a length prefix, to send after a frame started by finish(following).
+     */
+    std::string continuation();
+
+private:
+    std::string frame_;
+};
+
+/**
+ * @class FrameReader
+ * @brief Reads the fields of a received frame; every read fails once the frame runs out.
+ */
+class FrameReader
+{
+public:
+    explicit FrameReader(std::string_view frame) : data_(frame) {}
+
+    bool u8(uint8_t &value);
+    bool u16(uint16_t &value);
+    bool u32(uint32_t &value);
+    bool string(std::string_view &text);
+
+    bool at_end() const { return data_.empty(); }
+
+private:
+    std::string_view data_;
+};
+
+#endif // BINARY_PROTOCOL_H
@@ -0,0 +1,201 @@
+/*
+ * CATALOG
+ * -------
+ * Description: The shared, read-mostly course catalog. Every session reads from the one
+ *              instance loaded at startup instead of keeping a private copy of courses.db,
+ *              and reloads are published with an atomic swap.
+ */
+#include "catalog.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <iostream>
+
+std::string Catalog::snapshot_path(const std::string &filename)
+{
+    return std::filesystem::path(filename).replace_extension(".snap").string();
+}
+
+// Whether the snapshot exists and was written after the database file last changed
+static bool snapshot_is_fresh(const std::string &filename, const std::string &snapshot)
+{
+    std::error_code error;
+    auto snapshot_time = std::filesystem::last_write_time(snapshot, error);
+    if (error)
+    {
+        return false;
+    }
+    auto database_time = std::filesystem::last_write_time(filename, error);
+    return error || snapshot_time > database_time;
+}
+
+bool Catalog::load(const std::string &filename, unsigned threads)
+{
+    std::lock_guard guard(load_lock_);
+
+    // Build the whole new generation off to the side; readers keep using the current one meanwhile
+    auto next = std::make_shared<CatalogVersion>();
+    CourseTable &loaded = next->table;
+    std::string snapshot = snapshot_path(filename);
+    if (snapshot_is_fresh(filename, snapshot))
+    {
+        std::string error;
+        if (!loaded.open_snapshot(snapshot, error))
+        {
+            std::cerr << "Error: ignoring snapshot " << snapshot << ": " << error << std::endl;
+        }
+    }
+    if (loaded.size() == 0)
+    {
+        loaded = load_course_table(filename, threads);
+    }
+    if (loaded.size() == 0)
+    {
+        return false;
+    }
+    next->index = build_course_index(loaded);
+    std::vector<std::string> problems;
+    next->prerequisites.build(loaded, next->index, problems);
+    for (const std::string &problem : problems)
+    {
+        std::cerr << "Error: " << filename << ": " << problem << std::endl;
+    }
+    next->records.build(loaded);
+    next->text_index.build(loaded);
+    for (size_t row = 0; row < loaded.size(); row++)
+    {
+        next->code_column.add(loaded.course_code(row));
+        next->text_columns[TextIndex::TITLE].add(loaded.title(row));
+        next->text_columns[TextIndex::SUBJECT].add(loaded.subject(row));
+        next->text_columns[TextIndex::INSTRUCTOR].add(loaded.instructor(row));
+        next->text_columns[TextIndex::DESCRIPTION].add(loaded.description(row));
+    }
+
+    // Courses that are still listed keep their seat counter; only new ones start from the file
+    std::shared_ptr<const CatalogVersion> previous = current_.load(std::memory_order_acquire);
+    next->number = previous->number + 1;
+    next->seats.resize(loaded.size());
+    for (size_t row = 0; row < loaded.size(); row++)
+    {
+        int old_slot = find_course_slot(previous->table, previous->index, loaded.course_code(row));
+        if (old_slot != -1)
+        {
+            next->seats[row] = previous->seats[old_slot];
+            next->seats[row]->resize(loaded.capacity(row));
+        }
+        else
+        {
+            next->seats[row] = std::make_shared<SeatCounter>();
+            next->seats[row]->seats_available.store(loaded.seats_available(row), std::memory_order_relaxed);
+            next->seats[row]->capacity.store(loaded.capacity(row), std::memory_order_relaxed);
+        }
+    }
+
+    // Publish; the previous generation is freed once the last view of it goes away
+    current_.store(std::move(next), std::memory_order_release);
+    return true;
+}
+
+int Catalog::View::find(std::string_view course_code) const
+{
+    return find_course_slot(version_->table, version_->index, course_code);
+}
+
+// Whether the word index can answer a query, i.e. it holds only words, spaces and prefix stars
+static bool is_word_query(std::string_view search_term)
+{
+    for (unsigned char c : search_term)
+    {
+        if (!std::isalnum(c) && c != ' ' && c != '*')
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<uint32_t> Catalog::View::search(std::string_view filter, std::string_view search_term) const
+{
+    unsigned fields = 0;
+    if (filter == "title")
+    {
+        fields = 1u << TextIndex::TITLE;
+    }
+    else if (filter == "description")
+    {
+        fields = 1u << TextIndex::DESCRIPTION;
+    }
+    else if (filter == "keyword")
+    {
+        fields = TextIndex::ALL_FIELDS;
+    }
+    else if (filter == "course-code")
+    {
+        return version_->code_column.find(search_term);
+    }
+
+    if (fields != 0)
+    {
+        if (is_word_query(search_term))
+        {
+            return version_->text_index.query(search_term, fields);
+        }
+        std::vector<uint32_t> results;
+        for (int field = 0; field < TextIndex::FIELD_COUNT; field++)
+        {
+            if (fields & (1u << field))
+            {
+                std::vector<uint32_t> rows = version_->text_columns[field].find(search_term);
+                results.insert(results.end(), rows.begin(), rows.end());
+            }
+        }
+        std::sort(results.begin(), results.end());
+        results.erase(std::unique(results.begin(), results.end()), results.end());
+        return results;
+    }
+    return search_course_slots(version_->table, version_->index, filter, search_term);
+}
+
+bool SeatCounter::take()
+{
+    int current = seats_available.load(std::memory_order_relaxed);
+    do
+    {
+        if (current <= 0)
+        {
+            return false; // No seats available
+        }
+    } while (!seats_available.compare_exchange_weak(current, current - 1, std::memory_order_acq_rel, std::memory_order_relaxed));
+    return true;
+}
+
+bool SeatCounter::give_back()
+{
+    int current = seats_available.load(std::memory_order_relaxed);
+    do
+    {
+        if (current >= capacity.load(std::memory_order_relaxed))
+        {
+            return false; // Already at full capacity
+        }
+    } while (!seats_available.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel, std::memory_order_relaxed));
+    return true;
+}
+
+void SeatCounter::resize(int new_capacity)
+{
+    int old_capacity = capacity.exchange(new_capacity, std::memory_order_acq_rel);
+    int current = seats_available.load(std::memory_order_relaxed);
+    int resized;
+    do
+    {
+        resized = std::clamp(current + new_capacity - old_capacity, 0, new_capacity);
+    } while (!seats_available.compare_exchange_weak(current, resized, std::memory_order_acq_rel, std::memory_order_relaxed));
+}
+
+bool Catalog::drop_course(std::string_view course_code)
+{
+    View catalog = view();
+    int slot = catalog.find(course_code);
+    return slot != -1 && catalog.seats(slot).give_back();
+}
@@ -0,0 +1,216 @@
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "course_records.h"
+#include "p1_helper.h"
+#include "packed_column.h"
+#include "prerequisite_graph.h"
+#include "text_index.h"
+
+/**
+ * @struct SeatCounter
+ * @brief The live seat count of one course, shared by every session.
+ *
+ * Each counter sits on its own cache line so that a rush on one popular section
+ * does not slow down enrollments in its neighbours. A counter outlives catalog
+ * reloads for as long as its course code stays in the catalog.
+ */
+struct alignas(64) SeatCounter
+{
+    std::atomic<int> seats_available{0};
+    std::atomic<int> capacity{0};
+
+    /**
+     * @brief Takes one seat with compare-and-swap, never letting the count drop below zero.
+     * @return true if a seat was taken, false if the course is full.
+     */
+    bool take();
+
+    /**
+     * @brief Gives one seat back with compare-and-swap, never letting the count exceed capacity.
+     * @return true if a seat was returned, false if the course is already empty.
+     */
+    bool give_back();
+
+    /**
+     * @brief Applies a new capacity, growing or shrinking the open seats by the same amount.
+     *
+     * Seats already taken stay taken, so the count is clamped to [0, capacity].
+     */
+    void resize(int new_capacity);
+};
+
+/**
+ * @struct CatalogVersion
+ * @brief One immutable generation of the catalog: the course table and everything built from it.
+ *
+ * Only the seat counters are shared between generations.
+ */
+struct CatalogVersion
+{
+    uint64_t number = 0;
+    CourseTable table;
+    CourseIndex index;
+    PrerequisiteGraph prerequisites;
+    CourseRecords records;
+    TextIndex text_index;
+    PackedColumn code_column;
+    PackedColumn text_columns[TextIndex::FIELD_COUNT];
+    std::vector<std::shared_ptr<SeatCounter>> seats; // One per row
+};
+
+/**
+ * @class Catalog
+ * @brief The process-wide course catalog shared by every client session.
+ *
+ * The catalog is loaded once at startup and handed to each session by reference,
+ * so a new connection no longer re-reads courses.db. It can be reloaded while the
+ * server runs: the new generation is built off to the side and published with one
+ * atomic pointer swap (read-copy-update). Readers (LIST, SEARCH, SHOW) pin the
+ * generation that was current when they started and never block or see a mix of
+ * two generations; an old generation is freed when its last reader lets go.
+ * Seat counts live in a ledger of atomic counters that carries over across
+ * reloads, so ENROLL and DROP update seats with compare-and-swap.
+ *
+ * Courses are stored column by column in a CourseTable, and lookups go through
+ * the CourseIndex built at load time and hand out slots (table rows) instead of copies.
+ * Word searches over titles, subjects, instructors and descriptions go through
+ * a TextIndex, and substring filters no index can serve scan PackedColumn copies
+ * of the fields. Prerequisites are resolved to slots once, in a PrerequisiteGraph.
+ */
+class Catalog
+{
+public:
+    /**
+     * @class View
+     * @brief A consistent, read-only handle on one generation of the catalog.
+     *
+     * The view keeps its generation alive for as long as it lives, so the slots
+     * and references it hands out stay valid until it goes out of scope, even if
+     * the catalog is reloaded in the meantime.
+     */
+    class View
+    {
+    public:
+        /**
+         * @brief The slot of a course, or -1 if there is no such course code.
+         */
+        int find(std::string_view course_code) const;
+
+        /**
+         * @brief The column-oriented course table; slots are its rows. Its seats_available() is the loaded value, use the view's.
+         */
+        const CourseTable &table() const { return version_->table; }
+
+        /**
+         * @brief Every course's LIST line and SHOW details, rendered when this generation was loaded.
+         */
+        const CourseRecords &records() const { return version_->records; }
+
+        /**
+         * @brief The live number of seats available in a slot's course.
+         */
+        int seats_available(size_t slot) const { return version_->seats[slot]->seats_available.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief The shared seat counter of a slot's course, for taking or returning a seat.
+         */
+        SeatCounter &seats(size_t slot) const { return *version_->seats[slot]; }
+
+        /**
+         * @brief Searches the catalog, see search_courses() for the filter semantics.
+         *
+         * The "title", "description" and "keyword" (any text field) filters match
+         * whole words instead: every word of search_term must appear, and a word
+         * ending in '*' matches as a prefix. A search_term with punctuation other
+         * than '*' cannot be split into words and is matched as a substring.
+         * @return The slots of the matching courses, in catalog order.
+         */
+        std::vector<uint32_t> search(std::string_view filter, std::string_view search_term) const;
+
+        /**
+         * @brief The prerequisite DAG; check eligibility against a course_set().
+         */
+        const PrerequisiteGraph &prerequisites() const { return version_->prerequisites; }
+
+        /**
+         * @brief The slots of the given course codes, as a bitset; codes not in the catalog are left out.
+         */
+        template <typename CourseCodes>
+        CourseSet course_set(const CourseCodes &course_codes) const
+        {
+            CourseSet set;
+            for (const auto &course_code : course_codes)
+            {
+                int slot = find(course_code);
+                if (slot != -1)
+                {
+                    set.insert(slot);
+                }
+            }
+            return set;
+        }
+
+        /**
+         * @brief The number of courses in the catalog.
+         */
+        size_t size() const { return version_->table.size(); }
+
+        /**
+         * @brief Which generation this view reads; it goes up by one on every reload.
+         */
+        uint64_t version() const { return version_->number; }
+
+    private:
+        friend class Catalog;
+        explicit View(std::shared_ptr<const CatalogVersion> version) : version_(std::move(version)) {}
+
+        std::shared_ptr<const CatalogVersion> version_;
+    };
+
+    /**
+     * @brief Loads (or reloads) the catalog from the specified database file.
+     *
+     * If a binary snapshot of the file (see snapshot_path()) exists and is newer
+     * than it, the snapshot is mapped and served directly instead of parsing the
+     * text file. A snapshot that cannot be used is reported and skipped.
+     *
+     * On a reload, courses that are still listed keep their live seat counts,
+     * adjusted by any change in capacity; the seat counts in the file only apply
+     * to new courses. If nothing could be loaded the current catalog is kept.
+     * @param filename The name of the database file (e.g., "courses.db").
+     * @param threads How many threads parse the file; 0 uses every core.
+     * @return true if at least one course was loaded, false otherwise.
+     */
+    bool load(const std::string &filename, unsigned threads = 0);
+
+    /**
+     * @brief The snapshot that belongs to a database file: "courses.db" -> "courses.snap".
+     */
+    static std::string snapshot_path(const std::string &filename);
+
+    /**
+     * @brief Opens a read-only view of the current generation of the catalog.
+     */
+    View view() const { return View(current_.load(std::memory_order_acquire)); }
+
+    /**
+     * @brief Gives one seat back to a course, never letting the count exceed capacity.
+     * @param course_code The course to drop.
+     * @return true if a seat was returned, false if the course is already empty or not found.
+     */
+    bool drop_course(std::string_view course_code);
+
+private:
+    std::atomic<std::shared_ptr<const CatalogVersion>> current_{std::make_shared<const CatalogVersion>()};
+    std::mutex load_lock_; // One load at a time, so two reloads cannot both carry seats over from the same generation
+};
+
+#endif // CATALOG_H
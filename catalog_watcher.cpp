@@ -0,0 +1,148 @@
+/*
+ * CATALOG WATCHER
+ * ---------------
+ * Description: Triggers background catalog reloads on SIGHUP and on changes to courses.db.
+ */
+#include "catalog_watcher.h"
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+// How long to wait for a burst of file events (an editor saving, dbconvert renaming) to settle
+static const int SETTLE_MS = 200;
+
+void CatalogWatcher::block_reload_signal()
+{
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+}
+
+CatalogWatcher::CatalogWatcher(Catalog &catalog, std::string filename, unsigned threads, bool watch_files)
+    : catalog_(catalog), filename_(std::move(filename)), threads_(threads)
+{
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGHUP);
+    signal_fd_ = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signal_fd_ == -1)
+    {
+        perror("signalfd");
+    }
+
+    if (watch_files)
+    {
+        // Watch the directory rather than the file, which is usually replaced by a rename
+        std::filesystem::path directory = std::filesystem::path(filename_).parent_path();
+        inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify_fd_ == -1 || inotify_add_watch(inotify_fd_, directory.empty() ? "." : directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) == -1)
+        {
+            perror("inotify");
+        }
+    }
+
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    thread_ = std::jthread([this](std::stop_token stop)
+                           { run(stop); });
+}
+
+CatalogWatcher::~CatalogWatcher()
+{
+    thread_.request_stop();
+    uint64_t one = 1;
+    if (write(wake_fd_, &one, sizeof one) == -1)
+    {
+        perror("eventfd write");
+    }
+    thread_.join();
+    for (int fd : {signal_fd_, inotify_fd_, wake_fd_})
+    {
+        if (fd != -1)
+        {
+            close(fd);
+        }
+    }
+}
+
+// Drains a non-blocking descriptor; returns whether an inotify event named one of the watched files
+static bool drain_events(int fd, bool inotify, const std::string &database, const std::string &snapshot)
+{
+    alignas(inotify_event) char buffer[4096];
+    bool relevant = !inotify;
+    ssize_t bytes;
+    while ((bytes = read(fd, buffer, sizeof buffer)) > 0)
+    {
+        for (char *p = buffer; inotify && p < buffer + bytes;)
+        {
+            const inotify_event *event = reinterpret_cast<const inotify_event *>(p);
+            if (event->len > 0 && (database == event->name || snapshot == event->name))
+            {
+                relevant = true;
+            }
+            p += sizeof(inotify_event) + event->len;
+        }
+    }
+    return relevant;
+}
+
+void CatalogWatcher::run(std::stop_token stop)
+{
+    const std::string database = std::filesystem::path(filename_).filename().string();
+    const std::string snapshot = std::filesystem::path(Catalog::snapshot_path(filename_)).filename().string();
+    pollfd fds[3] = {{signal_fd_, POLLIN, 0}, {inotify_fd_, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+    bool pending = false;
+
+    while (!stop.stop_requested())
+    {
+        // With a reload pending, wait only until the burst of events settles
+        int ready = poll(fds, 3, pending ? SETTLE_MS : -1);
+        if (ready == -1)
+        {
+            if (errno != EINTR)
+            {
+                perror("poll");
+                return;
+            }
+            continue;
+        }
+        if (ready == 0)
+        {
+            pending = false;
+            reload();
+            continue;
+        }
+        if (fds[0].revents & POLLIN)
+        {
+            drain_events(signal_fd_, false, database, snapshot);
+            std::cout << "server: SIGHUP received, reloading " << filename_ << std::endl;
+            pending = true;
+        }
+        if ((fds[1].revents & POLLIN) && drain_events(inotify_fd_, true, database, snapshot))
+        {
+            pending = true;
+        }
+    }
+}
+
+void CatalogWatcher::reload()
+{
+    auto start = std::chrono::steady_clock::now();
+    if (!catalog_.load(filename_, threads_))
+    {
+        std::cerr << "server: reload of " << filename_ << " failed, keeping the current catalog" << std::endl;
+        return;
+    }
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    Catalog::View view = catalog_.view();
+    std::cout << "server: catalog version " << view.version() << " loaded, " << view.size() << " courses in " << ms << " ms" << std::endl;
+}
@@ -0,0 +1,60 @@
+#ifndef CATALOG_WATCHER_H
+#define CATALOG_WATCHER_H
+
+#include <string>
+#include <thread>
+#include "catalog.h"
+
+/**
+ * @class CatalogWatcher
+ * @brief Reloads the catalog in the background when asked to or when the database changes.
+ *
+ * A reload is triggered by SIGHUP, or (with watch_files) whenever the database
+ * file or its snapshot is rewritten or renamed into place. Changes arriving in
+ * quick succession are folded into a single reload. Reloads run on the
+ * watcher's own thread, so connections are never paused for them.
+ *
+ * SIGHUP must be blocked in every thread (see block_reload_signal()) for the
+ * watcher to receive it.
+ */
+class CatalogWatcher
+{
+public:
+    /**
+     * @brief Starts watching.
+     * @param catalog The catalog to reload.
+     * @param filename The database file it was loaded from (e.g., "courses.db").
+     * @param threads How many threads parse the file on a reload; 0 uses every core.
+     * @param watch_files Whether to reload on file changes as well as on SIGHUP.
+     */
+    CatalogWatcher(Catalog &catalog, std::string filename, unsigned threads, bool watch_files);
+
+    /**
+     * @brief Stops watching and joins the watcher thread.
+     */
+    ~CatalogWatcher();
+
+    CatalogWatcher(const CatalogWatcher &) = delete;
+    CatalogWatcher &operator=(const CatalogWatcher &) = delete;
+
+    /**
+     * @brief Blocks SIGHUP in the calling thread and every thread it starts afterwards.
+     *
+     * Call it from main before any other thread is started.
+     */
+    static void block_reload_signal();
+
+private:
+    void run(std::stop_token stop);
+    void reload();
+
+    Catalog &catalog_;
+    std::string filename_;
+    unsigned threads_;
+    int signal_fd_ = -1;
+    int inotify_fd_ = -1;
+    int wake_fd_ = -1;   // Written on shutdown to get the thread out of poll()
+    std::jthread thread_;
+};
+
+#endif // CATALOG_WATCHER_H
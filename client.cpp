@@ -35,7 +35,7 @@ void *get_in_addr(struct sockaddr *sa)
 
 
 void sendToServer(int socket, string message){
-    string msg_str = message;
+    string msg_str = message + "\r\n"; // The server reads newline-terminated commands
     const char *msg = msg_str.c_str();
     if (send(socket, msg, strlen(msg), 0) == -1)
     {
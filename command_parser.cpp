@@ -0,0 +1,156 @@
+/*
+ * COMMAND PARSER
+ * --------------
+ * Description: Splits a text protocol line into its verb and arguments over string_views,
+ *              with no copies and no allocations.
+ */
+#include "command_parser.h"
+#include <charconv>
+
+static bool is_blank(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+std::string_view trim(std::string_view text)
+{
+    while (!text.empty() && is_blank(text.front()))
+    {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && is_blank(text.back()))
+    {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+std::string_view next_word(std::string_view &text)
+{
+    text = trim(text);
+    size_t end = 0;
+    while (end < text.size() && !is_blank(text[end]))
+    {
+        end++;
+    }
+    std::string_view word = text.substr(0, end);
+    text = trim(text.substr(end));
+    return word;
+}
+
+// Parses a whole word as a decimal number
+static bool parse_number(std::string_view word, size_t &value)
+{
+    auto [end, error] = std::from_chars(word.data(), word.data() + word.size(), value);
+    return !word.empty() && error == std::errc() && end == word.data() + word.size();
+}
+
+bool take_page(std::string_view &arguments, Page &page, size_t default_size, size_t max_size)
+{
+    page = Page();
+    // The clause starts at the last PAGE word whose tail parses: "n" or "n SIZE k"
+    for (size_t start = arguments.rfind("PAGE"); start != std::string_view::npos; start = start == 0 ? std::string_view::npos : arguments.rfind("PAGE", start - 1))
+    {
+        std::string_view tail = arguments.substr(start);
+        if ((start > 0 && !is_blank(arguments[start - 1])) || next_word(tail) != "PAGE")
+        {
+            continue;
+        }
+        Page clause;
+        clause.size = default_size;
+        bool parsed = parse_number(next_word(tail), clause.number);
+        if (parsed && !tail.empty())
+        {
+            parsed = next_word(tail) == "SIZE" && parse_number(next_word(tail), clause.size) && tail.empty();
+        }
+        if (parsed)
+        {
+            arguments = trim(arguments.substr(0, start));
+            page = clause;
+            return page.number > 0 && page.size > 0 && page.size <= max_size;
+        }
+    }
+    return true;
+}
+
+// Looks a verb up by its length first, so most lines are rejected or matched with one comparison
+static Verb find_verb(std::string_view word)
+{
+    switch (word.size())
+    {
+    case 3:
+        return word == "BYE" ? Verb::Bye : Verb::Unknown;
+    case 4:
+        switch (word[0])
+        {
+        case 'H':
+            return word == "HELP" ? Verb::Help : Verb::Unknown;
+        case 'L':
+            return word == "LIST" ? Verb::List : Verb::Unknown;
+        case 'S':
+            return word == "SHOW" ? Verb::Show : Verb::Unknown;
+        case 'D':
+            return word == "DROP" ? Verb::Drop : Verb::Unknown;
+        }
+        return Verb::Unknown;
+    case 6:
+        switch (word[0])
+        {
+        case 'B':
+            return word == "BINARY" ? Verb::Binary : Verb::Unknown;
+        case 'S':
+            return word == "SEARCH" ? Verb::Search : Verb::Unknown;
+        case 'E':
+            return word == "ENROLL" ? Verb::Enroll : Verb::Unknown;
+        }
+        return Verb::Unknown;
+    case 7:
+        return word == "CATALOG" ? Verb::Catalog : Verb::Unknown;
+    case 8:
+        return word == "ELIGIBLE" ? Verb::Eligible : Verb::Unknown;
+    case 9:
+        return word == "MYCOURSES" ? Verb::MyCourses : Verb::Unknown;
+    case 10:
+        return word == "ENROLLMENT" ? Verb::Enrollment : word == "VIEWGRADES" ? Verb::ViewGrades : Verb::Unknown;
+    }
+    return Verb::Unknown;
+}
+
+Command parse_command(std::string_view line)
+{
+    Command command;
+    command.arguments = line;
+    command.verb = find_verb(next_word(command.arguments));
+    return command;
+}
+
+const char *mode_name(Mode mode)
+{
+    switch (mode)
+    {
+    case Mode::Catalog:
+        return "CATALOG";
+    case Mode::Enrollment:
+        return "ENROLLMENT";
+    case Mode::MyCourses:
+        return "MYCOURSES";
+    case Mode::None:
+        break;
+    }
+    return "NO MODE";
+}
+
+Mode parse_mode(std::string_view name)
+{
+    switch (find_verb(name))
+    {
+    case Verb::Catalog:
+        return Mode::Catalog;
+    case Verb::Enrollment:
+        return Mode::Enrollment;
+    case Verb::MyCourses:
+        return Mode::MyCourses;
+    default:
+        return Mode::None;
+    }
+}
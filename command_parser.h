@@ -0,0 +1,99 @@
+#ifndef COMMAND_PARSER_H
+#define COMMAND_PARSER_H
+
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @brief The verbs of the text protocol, in the order HELP lists them.
+ */
+enum class Verb : uint8_t
+{
+    Unknown,
+    Bye,
+    Help,
+    Binary,
+    Catalog,
+    Enrollment,
+    MyCourses,
+    List,
+    Search,
+    Show,
+    Enroll,
+    Eligible,
+    Drop,
+    ViewGrades
+};
+
+/**
+ * @brief The mode a text session is in, which decides what LIST and HELP do and which verbs are allowed.
+ */
+enum class Mode : uint8_t
+{
+    None,
+    Catalog,
+    Enrollment,
+    MyCourses
+};
+
+/**
+ * @struct Command
+ * @brief One parsed command line. Every field views the line it was parsed from, so keep the line alive.
+ */
+struct Command
+{
+    Verb verb = Verb::Unknown;
+    std::string_view arguments; // Everything after the verb, without leading or trailing blanks
+};
+
+/**
+ * @struct Page
+ * @brief A "PAGE n SIZE k" clause: page n (counted from 1) of the results, k per page.
+ */
+struct Page
+{
+    size_t number = 0; // 0 if the command asked for every result
+    size_t size = 0;
+};
+
+/**
+ * @brief Parses a command line in one pass without allocating.
+ *
+ * The verb is the first word and must match exactly, so a line like "BLISTER"
+ * or "XLIST" is Verb::Unknown rather than a LIST. Verbs are looked up with a
+ * switch on their length followed by at most two comparisons.
+ */
+Command parse_command(std::string_view line);
+
+/**
+ * @brief The mode's name as the protocol spells it, e.g. "CATALOG", or "NO MODE".
+ */
+const char *mode_name(Mode mode);
+
+/**
+ * @brief The mode named by mode_name(), or Mode::None for anything else.
+ */
+Mode parse_mode(std::string_view name);
+
+/**
+ * @brief Takes the next blank-separated word off the front of text.
+ * @return The word, or an empty view if text has no more words.
+ */
+std::string_view next_word(std::string_view &text);
+
+/**
+ * @brief Takes a trailing "PAGE n [SIZE k]" clause off a command's arguments.
+ *
+ * Without SIZE a page holds default_size results. A PAGE that is not followed
+ * by a number up to the end of the line is an ordinary word and stays put.
+ * @param page Set to the clause, or left with number 0 if there is none.
+ * @return false if the clause asks for page 0, size 0 or more than max_size results.
+ */
+bool take_page(std::string_view &arguments, Page &page, size_t default_size, size_t max_size);
+
+/**
+ * @brief Strips leading and trailing blanks (spaces and tabs).
+ */
+std::string_view trim(std::string_view text);
+
+#endif // COMMAND_PARSER_H
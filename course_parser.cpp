@@ -0,0 +1,121 @@
+/*
+ * COURSE PARSER
+ * -------------
+ * Description: In-place parser for the semicolon-separated courses.db format.
+ */
+#include "course_parser.h"
+#include <charconv>
+#include <cstring>
+
+// Course Code; Title; Subject; Instructor; Prerequisites; Seats; Capacity; Description
+enum RowField
+{
+    CODE,
+    TITLE,
+    SUBJECT,
+    INSTRUCTOR,
+    PREREQUISITES,
+    SEATS,
+    CAPACITY,
+    DESCRIPTION,
+    ROW_FIELDS
+};
+
+// Parses a whole field as a non-negative count
+static bool parse_count(std::string_view field, int &value)
+{
+    const char *end = field.data() + field.size();
+    auto [stop, error] = std::from_chars(field.data(), end, value);
+    return error == std::errc() && stop == end && value >= 0;
+}
+
+static bool is_blank(std::string_view line)
+{
+    return line.find_first_not_of(" \t") == std::string_view::npos;
+}
+
+size_t parse_course_rows(std::string_view text, size_t first_line, CourseTable &table, std::vector<ParseError> &errors)
+{
+    std::string_view fields[ROW_FIELDS];
+    std::vector<std::string_view> prerequisites;
+    size_t line_number = first_line;
+    const char *p = text.data();
+    const char *end = p + text.size();
+
+    for (; p < end; line_number++)
+    {
+        const char *newline = static_cast<const char *>(std::memchr(p, '\n', end - p));
+        const char *line_end = newline != nullptr ? newline : end;
+        std::string_view line(p, line_end - p);
+        p = line_end + 1;
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.remove_suffix(1);
+        }
+        if (is_blank(line))
+        {
+            continue;
+        }
+
+        size_t count = 0;
+        while (true)
+        {
+            size_t semicolon = line.find(';');
+            if (count < ROW_FIELDS)
+            {
+                fields[count] = line.substr(0, semicolon);
+            }
+            count++;
+            if (semicolon == std::string_view::npos)
+            {
+                break;
+            }
+            line.remove_prefix(semicolon + 1);
+        }
+        if (count != ROW_FIELDS)
+        {
+            errors.push_back({line_number, "expected " + std::to_string(ROW_FIELDS) + " fields separated by ';', found " + std::to_string(count)});
+            continue;
+        }
+        if (fields[CODE].empty())
+        {
+            errors.push_back({line_number, "missing course code"});
+            continue;
+        }
+
+        int seats_available = 0;
+        int capacity = 0;
+        if (!parse_count(fields[SEATS], seats_available))
+        {
+            errors.push_back({line_number, "seats '" + std::string(fields[SEATS]) + "' is not a non-negative number"});
+            continue;
+        }
+        if (!parse_count(fields[CAPACITY], capacity))
+        {
+            errors.push_back({line_number, "capacity '" + std::string(fields[CAPACITY]) + "' is not a non-negative number"});
+            continue;
+        }
+        if (seats_available > capacity)
+        {
+            errors.push_back({line_number, "seats (" + std::to_string(seats_available) + ") exceed capacity (" + std::to_string(capacity) + ")"});
+            continue;
+        }
+
+        // Prerequisites (comma-separated list)
+        prerequisites.clear();
+        std::string_view list = fields[PREREQUISITES];
+        while (!list.empty())
+        {
+            size_t comma = list.find(',');
+            std::string_view code = list.substr(0, comma);
+            if (!code.empty())
+            {
+                prerequisites.push_back(code);
+            }
+            list.remove_prefix(comma == std::string_view::npos ? list.size() : comma + 1);
+        }
+
+        table.add(fields[CODE], fields[TITLE], fields[SUBJECT], fields[INSTRUCTOR], prerequisites, seats_available, capacity, fields[DESCRIPTION]);
+    }
+    return line_number - first_line;
+}
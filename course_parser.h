@@ -0,0 +1,33 @@
+#ifndef COURSE_PARSER_H
+#define COURSE_PARSER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "course_table.h"
+
+/**
+ * @struct ParseError
+ * @brief A row of courses.db that was rejected, and why.
+ */
+struct ParseError {
+    size_t line;         // 1-based line number in the file
+    std::string message;
+};
+
+/**
+ * @brief Parses rows of the semicolon-separated courses.db format into a course table.
+ *
+ * Fields are sliced out of text in place and handed to the table as string_views,
+ * so nothing is copied except the first occurrence of each distinct string. Blank
+ * lines are skipped. A row without exactly eight fields, or whose seats or capacity
+ * are not valid counts, is left out and reported in errors.
+ * @param text Whole lines of the file, without the header line.
+ * @param first_line The line number of the first line in text, for error reports.
+ * @param table The table the courses are appended to.
+ * @param errors The rejected rows are appended here.
+ * @return The number of lines in text.
+ */
+size_t parse_course_rows(std::string_view text, size_t first_line, CourseTable& table, std::vector<ParseError>& errors);
+
+#endif // COURSE_PARSER_H
@@ -0,0 +1,68 @@
+/*
+ * COURSE RECORDS
+ * --------------
+ * Description: Pre-rendered LIST lines and SHOW details for every course, kept in one
+ *              shared arena that replies point into.
+ */
+#include "course_records.h"
+
+void CourseRecords::build(const CourseTable &table)
+{
+    size_t rows = table.size();
+    list_starts_.assign(rows + 1, 0);
+    show_starts_.assign(rows + 1, 0);
+    show_holes_.assign(rows, 0);
+
+    // The records repeat each course's fields plus fixed labels, so the arena can be sized up front
+    size_t estimate = 0;
+    for (size_t row = 0; row < rows; row++)
+    {
+        size_t fields = table.course_code(row).size() + table.title(row).size();
+        estimate += 2 * fields + 2 + table.subject(row).size() + table.instructor(row).size() + table.description(row).size() + 128;
+        for (size_t i = 0; i < table.prerequisite_count(row); i++)
+        {
+            estimate += table.prerequisite(row, i).size() + 2;
+        }
+    }
+    std::string arena;
+    arena.reserve(estimate);
+
+    for (size_t row = 0; row < rows; row++)
+    {
+        list_starts_[row] = arena.size();
+        arena.append(table.course_code(row));
+        arena.append(" ");
+        arena.append(table.title(row));
+        arena.append("\n");
+    }
+    list_starts_[rows] = arena.size();
+
+    for (size_t row = 0; row < rows; row++)
+    {
+        show_starts_[row] = arena.size();
+        arena.append("Course Code: ");
+        arena.append(table.course_code(row));
+        arena.append("\nTitle: ");
+        arena.append(table.title(row));
+        arena.append("\nSubject: ");
+        arena.append(table.subject(row));
+        arena.append("\nInstructor: ");
+        arena.append(table.instructor(row));
+        arena.append("\nSeat Capacity: ");
+        arena.append(std::to_string(table.capacity(row)));
+        arena.append("\nAvailable Seats: ");
+        show_holes_[row] = arena.size();
+        arena.append("\nPrereqs: ");
+        for (size_t i = 0; i < table.prerequisite_count(row); i++)
+        {
+            arena.append(i == 0 ? "" : ", ");
+            arena.append(table.prerequisite(row, i));
+        }
+        arena.append("\nDescription: ");
+        arena.append(table.description(row));
+        arena.append("\n");
+    }
+    show_starts_[rows] = arena.size();
+
+    arena_ = std::make_shared<const std::string>(std::move(arena));
+}
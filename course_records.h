@@ -0,0 +1,60 @@
+#ifndef COURSE_RECORDS_H
+#define COURSE_RECORDS_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "p1_helper.h"
+
+/**
+ * @class CourseRecords
+ * @brief The LIST line and SHOW details of every course, rendered once per catalog load.
+ *
+ * All records share one immutable arena, so a reply queues slices of it instead
+ * of rendering or copying text. The LIST lines come first, one after another in
+ * slot order, so listing a run of consecutive slots is a single slice. A SHOW
+ * record is split around its live seat count, which is the only part a reply
+ * has to format.
+ */
+class CourseRecords
+{
+public:
+    /**
+     * @brief Renders every course of a table, replacing any previous records.
+     */
+    void build(const CourseTable &table);
+
+    /**
+     * @brief "<code> <title>\n", as LIST, SEARCH and ELIGIBLE print it.
+     */
+    std::string_view list_line(size_t slot) const { return slice(list_starts_[slot], list_starts_[slot + 1]); }
+
+    /**
+     * @brief The SHOW details up to the seat count: "Course Code: ...\nAvailable Seats: ".
+     */
+    std::string_view show_head(size_t slot) const { return slice(show_starts_[slot], show_holes_[slot]); }
+
+    /**
+     * @brief The SHOW details after the seat count: "\nPrereqs: ...\nDescription: ...\n".
+     */
+    std::string_view show_tail(size_t slot) const { return slice(show_holes_[slot], show_starts_[slot + 1]); }
+
+    /**
+     * @brief The buffer every record views, to keep it alive while the slices are queued.
+     */
+    const std::shared_ptr<const std::string> &arena() const { return arena_; }
+
+    size_t bytes() const { return arena_ ? arena_->size() : 0; }
+
+private:
+    std::string_view slice(uint64_t begin, uint64_t end) const { return std::string_view(*arena_).substr(begin, end - begin); }
+
+    std::shared_ptr<const std::string> arena_;
+    std::vector<uint64_t> list_starts_; // LIST line of slot i is [list_starts_[i], list_starts_[i + 1])
+    std::vector<uint64_t> show_starts_; // SHOW record of slot i is [show_starts_[i], show_starts_[i + 1])
+    std::vector<uint64_t> show_holes_;  // Where the seat count goes in the SHOW record of slot i
+};
+
+#endif // COURSE_RECORDS_H
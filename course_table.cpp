@@ -0,0 +1,425 @@
+/*
+ * COURSE TABLE
+ * ------------
+ * Description: The column-oriented, string-interned in-memory catalog.
+ */
+#include "course_table.h"
+#include "mapped_file.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fcntl.h>
+#include <unistd.h>
+
+CourseTable::StringId CourseTable::intern(std::string_view text)
+{
+    // Each bucket holds the low 32 bits of the string's hash above id + 1 (0 marks an empty bucket),
+    // so growing never re-hashes a string and most mismatches are rejected without a compare
+    if (intern_buckets_.size() < string_count() * 2 + 2)
+    {
+        size_t size = std::max<size_t>(64, intern_buckets_.size() * 2);
+        while (size < string_count() * 2 + 2)
+        {
+            size *= 2;
+        }
+        std::vector<uint64_t> buckets(size, 0);
+        if (intern_buckets_.empty())
+        {
+            // First use, or the strings were merged in by append(): hash them all once
+            for (StringId id = 0; id < string_count(); id++)
+            {
+                insert_bucket(buckets, static_cast<uint32_t>(fnv1a_hash(string(id))), id);
+            }
+        }
+        for (uint64_t entry : intern_buckets_)
+        {
+            if (entry != 0)
+            {
+                insert_bucket(buckets, entry >> 32, static_cast<uint32_t>(entry) - 1);
+            }
+        }
+        intern_buckets_.swap(buckets);
+    }
+
+    const uint32_t hash = static_cast<uint32_t>(fnv1a_hash(text));
+    size_t mask = intern_buckets_.size() - 1;
+    size_t bucket = hash & mask;
+    while (intern_buckets_[bucket] != 0)
+    {
+        uint64_t entry = intern_buckets_[bucket];
+        StringId id = static_cast<uint32_t>(entry) - 1;
+        if ((entry >> 32) == hash && string(id) == text)
+        {
+            return id;
+        }
+        bucket = (bucket + 1) & mask;
+    }
+
+    StringId id = static_cast<StringId>(string_count());
+    arena_.values().insert(arena_.values().end(), text.begin(), text.end());
+    string_offsets_.values().push_back(static_cast<uint32_t>(arena_.size()));
+    intern_buckets_[bucket] = static_cast<uint64_t>(hash) << 32 | (id + 1);
+    return id;
+}
+
+void CourseTable::insert_bucket(std::vector<uint64_t> &buckets, uint32_t hash, StringId id)
+{
+    size_t bucket = hash & (buckets.size() - 1);
+    while (buckets[bucket] != 0)
+    {
+        bucket = (bucket + 1) & (buckets.size() - 1);
+    }
+    buckets[bucket] = static_cast<uint64_t>(hash) << 32 | (id + 1);
+}
+
+size_t CourseTable::add(std::string_view course_code, std::string_view title, std::string_view subject, std::string_view instructor,
+                        const std::vector<std::string_view> &prerequisites, int seats_available, int capacity, std::string_view description)
+{
+    code_.values().push_back(intern(course_code));
+    title_.values().push_back(intern(title));
+    subject_.values().push_back(intern(subject));
+    instructor_.values().push_back(intern(instructor));
+    description_.values().push_back(intern(description));
+    for (std::string_view prerequisite : prerequisites)
+    {
+        prereq_codes_.values().push_back(intern(prerequisite));
+    }
+    prereq_offsets_.values().push_back(static_cast<uint32_t>(prereq_codes_.size()));
+    seats_.values().push_back(seats_available);
+    capacity_.values().push_back(capacity);
+    return code_.size() - 1;
+}
+
+void CourseTable::append(CourseTable &&other)
+{
+    if (code_.empty() && string_count() == 0)
+    {
+        *this = std::move(other); // Nothing to merge with, e.g. the first chunk
+        other = CourseTable();
+        return;
+    }
+    const StringId id_base = static_cast<StringId>(string_count());
+    const uint32_t arena_base = static_cast<uint32_t>(arena_.size());
+    const uint32_t prereq_base = static_cast<uint32_t>(prereq_codes_.size());
+
+    arena_.values().insert(arena_.values().end(), other.arena_.data(), other.arena_.data() + other.arena_.size());
+    for (size_t id = 1; id < other.string_offsets_.size(); id++)
+    {
+        string_offsets_.values().push_back(arena_base + other.string_offsets_[id]);
+    }
+    auto append_ids = [id_base](Column<StringId> &to, const Column<StringId> &from)
+    {
+        to.values().reserve(to.size() + from.size());
+        for (size_t i = 0; i < from.size(); i++)
+        {
+            to.values().push_back(id_base + from[i]);
+        }
+    };
+    append_ids(code_, other.code_);
+    append_ids(title_, other.title_);
+    append_ids(subject_, other.subject_);
+    append_ids(instructor_, other.instructor_);
+    append_ids(description_, other.description_);
+    append_ids(prereq_codes_, other.prereq_codes_);
+    for (size_t row = 1; row < other.prereq_offsets_.size(); row++)
+    {
+        prereq_offsets_.values().push_back(prereq_base + other.prereq_offsets_[row]);
+    }
+    seats_.values().insert(seats_.values().end(), other.seats_.data(), other.seats_.data() + other.seats_.size());
+    capacity_.values().insert(capacity_.values().end(), other.capacity_.data(), other.capacity_.data() + other.capacity_.size());
+
+    // The intern table no longer covers every string; intern() rebuilds it on the next add()
+    std::vector<uint64_t>().swap(intern_buckets_);
+    other = CourseTable();
+}
+
+void CourseTable::finish()
+{
+    std::vector<uint64_t>().swap(intern_buckets_);
+    arena_.values().shrink_to_fit();
+    string_offsets_.values().shrink_to_fit();
+    for (auto *column : {&code_, &title_, &subject_, &instructor_, &description_, &prereq_codes_, &prereq_offsets_})
+    {
+        column->values().shrink_to_fit();
+    }
+    seats_.values().shrink_to_fit();
+    capacity_.values().shrink_to_fit();
+}
+
+/*
+ * Snapshot layout, version 1. Everything is in the writer's native byte order,
+ * which byte_order records so a foreign snapshot is rejected instead of misread.
+ *
+ *   SnapshotHeader    magic, version, row/string/edge counts and a section table
+ *   sections          one per Section, each starting on an 8-byte boundary:
+ *                       ARENA            the string arena (chars)
+ *                       STRING_OFFSETS   uint32 x (strings + 1)
+ *                       CODES..DESCRIPTIONS  uint32 string id x rows, one per text field
+ *                       PREREQ_OFFSETS   uint32 x (rows + 1)
+ *                       PREREQ_CODES     uint32 string id x edges
+ *                       SEATS, CAPACITY  int32 x rows
+ */
+static const char SNAPSHOT_MAGIC[8] = {'C', 'R', 'S', 'S', 'N', 'A', 'P', '\0'};
+static const uint32_t SNAPSHOT_VERSION = 1;
+static const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+enum Section
+{
+    ARENA,
+    STRING_OFFSETS,
+    CODES,
+    TITLES,
+    SUBJECTS,
+    INSTRUCTORS,
+    DESCRIPTIONS,
+    PREREQ_OFFSETS,
+    PREREQ_CODES,
+    SEATS,
+    CAPACITY,
+    SECTION_COUNT
+};
+
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t rows;
+    uint64_t strings;
+    uint64_t prerequisite_edges;
+    struct
+    {
+        uint64_t offset;
+        uint64_t bytes;
+    } sections[SECTION_COUNT];
+};
+
+// Writes every byte, retrying short writes and interrupted calls
+static bool write_all(int fd, const void *data, size_t bytes)
+{
+    const char *next = static_cast<const char *>(data);
+    while (bytes > 0)
+    {
+        ssize_t written = ::write(fd, next, bytes);
+        if (written == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        next += written;
+        bytes -= written;
+    }
+    return true;
+}
+
+// Makes a file's rename durable
+static void sync_directory(const std::string &path)
+{
+    std::filesystem::path directory = std::filesystem::path(path).parent_path();
+    int fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd != -1)
+    {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+bool CourseTable::write_snapshot(const std::string &filename, std::string &error) const
+{
+    struct
+    {
+        const void *data;
+        size_t bytes;
+    } sections[SECTION_COUNT] = {
+        {arena_.data(), arena_.size()},
+        {string_offsets_.data(), string_offsets_.size() * sizeof(uint32_t)},
+        {code_.data(), code_.size() * sizeof(StringId)},
+        {title_.data(), title_.size() * sizeof(StringId)},
+        {subject_.data(), subject_.size() * sizeof(StringId)},
+        {instructor_.data(), instructor_.size() * sizeof(StringId)},
+        {description_.data(), description_.size() * sizeof(StringId)},
+        {prereq_offsets_.data(), prereq_offsets_.size() * sizeof(uint32_t)},
+        {prereq_codes_.data(), prereq_codes_.size() * sizeof(StringId)},
+        {seats_.data(), seats_.size() * sizeof(int32_t)},
+        {capacity_.data(), capacity_.size() * sizeof(int32_t)},
+    };
+
+    SnapshotHeader header = {};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof header.magic);
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.rows = size();
+    header.strings = string_count();
+    header.prerequisite_edges = prereq_codes_.size();
+    uint64_t offset = sizeof header;
+    for (int section = 0; section < SECTION_COUNT; section++)
+    {
+        offset = (offset + 7) & ~uint64_t(7);
+        header.sections[section].offset = offset;
+        header.sections[section].bytes = sections[section].bytes;
+        offset += sections[section].bytes;
+    }
+
+    // Write under a temporary name so a reader never maps a half-written snapshot, and sync the file
+    // before the rename (and the directory after it) so a crash cannot leave a torn one in place
+    std::string temporary = filename + ".tmp";
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    bool written = fd != -1 && write_all(fd, &header, sizeof header);
+    uint64_t position = sizeof header;
+    static const char padding[8] = {};
+    for (int section = 0; section < SECTION_COUNT && written; section++)
+    {
+        written = write_all(fd, padding, header.sections[section].offset - position) &&
+                  write_all(fd, sections[section].data, sections[section].bytes);
+        position = header.sections[section].offset + sections[section].bytes;
+    }
+    if (!written || fsync(fd) == -1)
+    {
+        error = "could not write " + temporary + ": " + std::strerror(errno);
+        if (fd != -1)
+        {
+            close(fd);
+            unlink(temporary.c_str());
+        }
+        return false;
+    }
+    close(fd);
+    if (std::rename(temporary.c_str(), filename.c_str()) != 0)
+    {
+        error = std::strerror(errno);
+        std::remove(temporary.c_str());
+        return false;
+    }
+    sync_directory(filename);
+    return true;
+}
+
+// Whether every id in [ids, ids + count) names one of the snapshot's strings
+static bool ids_in_range(const uint32_t *ids, size_t count, uint64_t strings)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (ids[i] >= strings)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Whether offsets starts at 0, never decreases and ends at end
+static bool offsets_valid(const uint32_t *offsets, size_t count, uint64_t end)
+{
+    if (offsets[0] != 0 || offsets[count - 1] != end)
+    {
+        return false;
+    }
+    for (size_t i = 1; i < count; i++)
+    {
+        if (offsets[i] < offsets[i - 1])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CourseTable::open_snapshot(const std::string &filename, std::string &error)
+{
+    *this = CourseTable();
+    auto file = std::make_shared<MappedFile>();
+    if (!file->open(filename, error))
+    {
+        return false;
+    }
+    const char *base = file->data().data();
+    const size_t file_size = file->size();
+
+    SnapshotHeader header;
+    if (file_size < sizeof header)
+    {
+        error = "file is too short to be a snapshot";
+        return false;
+    }
+    std::memcpy(&header, base, sizeof header);
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof header.magic) != 0)
+    {
+        error = "not a course snapshot";
+        return false;
+    }
+    if (header.version != SNAPSHOT_VERSION)
+    {
+        error = "unsupported snapshot version " + std::to_string(header.version);
+        return false;
+    }
+    if (header.byte_order != SNAPSHOT_BYTE_ORDER)
+    {
+        error = "snapshot was written with a different byte order";
+        return false;
+    }
+    if (header.rows >= UINT32_MAX || header.strings >= UINT32_MAX || header.prerequisite_edges >= UINT32_MAX)
+    {
+        error = "snapshot counts are out of range";
+        return false;
+    }
+
+    const uint64_t expected[SECTION_COUNT] = {
+        header.sections[ARENA].bytes,
+        (header.strings + 1) * sizeof(uint32_t),
+        header.rows * sizeof(StringId),
+        header.rows * sizeof(StringId),
+        header.rows * sizeof(StringId),
+        header.rows * sizeof(StringId),
+        header.rows * sizeof(StringId),
+        (header.rows + 1) * sizeof(uint32_t),
+        header.prerequisite_edges * sizeof(StringId),
+        header.rows * sizeof(int32_t),
+        header.rows * sizeof(int32_t),
+    };
+    for (int section = 0; section < SECTION_COUNT; section++)
+    {
+        uint64_t offset = header.sections[section].offset;
+        uint64_t bytes = header.sections[section].bytes;
+        if (bytes != expected[section] || offset % 8 != 0 || offset > file_size || bytes > file_size - offset)
+        {
+            error = "snapshot section " + std::to_string(section) + " is truncated or malformed";
+            return false;
+        }
+    }
+
+    auto section = [&](int which)
+    { return base + header.sections[which].offset; };
+    arena_.view(section(ARENA), header.sections[ARENA].bytes);
+    string_offsets_.view(reinterpret_cast<const uint32_t *>(section(STRING_OFFSETS)), header.strings + 1);
+    code_.view(reinterpret_cast<const StringId *>(section(CODES)), header.rows);
+    title_.view(reinterpret_cast<const StringId *>(section(TITLES)), header.rows);
+    subject_.view(reinterpret_cast<const StringId *>(section(SUBJECTS)), header.rows);
+    instructor_.view(reinterpret_cast<const StringId *>(section(INSTRUCTORS)), header.rows);
+    description_.view(reinterpret_cast<const StringId *>(section(DESCRIPTIONS)), header.rows);
+    prereq_offsets_.view(reinterpret_cast<const uint32_t *>(section(PREREQ_OFFSETS)), header.rows + 1);
+    prereq_codes_.view(reinterpret_cast<const StringId *>(section(PREREQ_CODES)), header.prerequisite_edges);
+    seats_.view(reinterpret_cast<const int32_t *>(section(SEATS)), header.rows);
+    capacity_.view(reinterpret_cast<const int32_t *>(section(CAPACITY)), header.rows);
+
+    // One sequential pass so a corrupt snapshot is rejected here rather than read out of bounds later
+    bool valid = offsets_valid(string_offsets_.data(), string_offsets_.size(), arena_.size()) &&
+                 offsets_valid(prereq_offsets_.data(), prereq_offsets_.size(), prereq_codes_.size()) &&
+                 ids_in_range(prereq_codes_.data(), prereq_codes_.size(), header.strings);
+    for (const Column<StringId> *column : {&code_, &title_, &subject_, &instructor_, &description_})
+    {
+        valid = valid && ids_in_range(column->data(), column->size(), header.strings);
+    }
+    if (!valid)
+    {
+        *this = CourseTable();
+        error = "snapshot offsets or string ids are out of range";
+        return false;
+    }
+    snapshot_ = std::move(file);
+    return true;
+}
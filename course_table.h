@@ -0,0 +1,169 @@
+#ifndef COURSE_TABLE_H
+#define COURSE_TABLE_H
+
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class MappedFile;
+
+/**
+ * @brief 64-bit FNV-1a, used to hash course codes and interned strings.
+ */
+inline uint64_t fnv1a_hash(std::string_view text)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : text)
+    {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+/**
+ * @class Column
+ * @brief One column of a CourseTable: values it owns, or a read-only view of values in a mapped snapshot.
+ */
+template <typename T>
+class Column
+{
+public:
+    Column() = default;
+    Column(std::initializer_list<T> values) : values_(values) {}
+
+    const T &operator[](size_t i) const { return data()[i]; }
+    const T *data() const { return view_ != nullptr ? view_ : values_.data(); }
+    size_t size() const { return view_ != nullptr ? view_size_ : values_.size(); }
+    bool empty() const { return size() == 0; }
+
+    /**
+     * @brief The owned values, for building the column. Not valid while viewing a snapshot.
+     */
+    std::vector<T> &values() { return values_; }
+
+    /**
+     * @brief Serves the column from memory owned by someone else (a mapped snapshot).
+     */
+    void view(const T *data, size_t size)
+    {
+        std::vector<T>().swap(values_);
+        view_ = data;
+        view_size_ = size;
+    }
+
+private:
+    std::vector<T> values_;
+    const T *view_ = nullptr;
+    size_t view_size_ = 0;
+};
+
+/**
+ * @class CourseTable
+ * @brief The course catalog in a structure-of-arrays layout.
+ *
+ * Every distinct string (codes, titles, subjects, instructors, descriptions) is
+ * stored once (once per merged chunk, see append()) in a single character arena
+ * and referred to by a 32-bit id, so a row is just a handful of integers spread
+ * over packed columns:
+ *   - one string id column per text field,
+ *   - prerequisites as CSR edges (row -> range of prerequisite code ids),
+ *   - seats and capacity as plain int columns.
+ * A full scan walks a few contiguous arrays instead of chasing pointers through
+ * seven heap-allocated strings and a vector per course.
+ *
+ * The same columns can be written to a binary snapshot and later served straight
+ * out of a read-only mapping of it, with nothing parsed or copied at startup.
+ */
+class CourseTable
+{
+public:
+    using StringId = uint32_t;
+
+    /**
+     * @brief Appends a course; the strings are copied into the arena (once per distinct value).
+     * @return The new row.
+     */
+    size_t add(std::string_view course_code, std::string_view title, std::string_view subject, std::string_view instructor,
+               const std::vector<std::string_view> &prerequisites, int seats_available, int capacity, std::string_view description);
+
+    /**
+     * @brief Appends every row of another table, in order, and empties it.
+     *
+     * The other table's strings are copied over as a block rather than interned
+     * again, so a value that occurs in both tables is stored twice. This keeps
+     * merging the chunks of a parallel load a sequential copy.
+     */
+    void append(CourseTable &&other);
+
+    /**
+     * @brief Drops the build-time lookup structures and trims spare capacity.
+     */
+    void finish();
+
+    /**
+     * @brief Writes the table as a binary snapshot (the layout is described in course_table.cpp).
+     * @param filename The snapshot file; it is written under a temporary name and renamed into place.
+     * @param error Set to a description of the failure when false is returned.
+     * @return true if the snapshot was written.
+     */
+    bool write_snapshot(const std::string &filename, std::string &error) const;
+
+    /**
+     * @brief Maps a binary snapshot and serves the table directly out of the mapping.
+     * @param filename The snapshot file.
+     * @param error Set to a description of the failure when false is returned.
+     * @return true if the snapshot was valid; the table is left empty otherwise.
+     *
+     * A table opened this way is read-only: do not add() to it.
+     */
+    bool open_snapshot(const std::string &filename, std::string &error);
+
+    size_t size() const { return code_.size(); }
+
+    std::string_view course_code(size_t row) const { return string(code_[row]); }
+    std::string_view title(size_t row) const { return string(title_[row]); }
+    std::string_view subject(size_t row) const { return string(subject_[row]); }
+    std::string_view instructor(size_t row) const { return string(instructor_[row]); }
+    std::string_view description(size_t row) const { return string(description_[row]); }
+    int seats_available(size_t row) const { return seats_[row]; }
+    int capacity(size_t row) const { return capacity_[row]; }
+
+    size_t prerequisite_count(size_t row) const { return prereq_offsets_[row + 1] - prereq_offsets_[row]; }
+    std::string_view prerequisite(size_t row, size_t i) const { return string(prereq_codes_[prereq_offsets_[row] + i]); }
+
+    StringId course_code_id(size_t row) const { return code_[row]; }
+    StringId subject_id(size_t row) const { return subject_[row]; }
+    StringId instructor_id(size_t row) const { return instructor_[row]; }
+
+    /**
+     * @brief The text of an interned string.
+     */
+    std::string_view string(StringId id) const { return std::string_view(arena_.data() + string_offsets_[id], string_offsets_[id + 1] - string_offsets_[id]); }
+
+    /**
+     * @brief The number of distinct strings and the bytes they occupy, for memory reports.
+     */
+    size_t string_count() const { return string_offsets_.size() - 1; }
+    size_t arena_bytes() const { return arena_.size(); }
+
+private:
+    StringId intern(std::string_view text);
+    static void insert_bucket(std::vector<uint64_t> &buckets, uint32_t hash, StringId id);
+
+    Column<char> arena_;                             // Every distinct string, back to back
+    Column<uint32_t> string_offsets_ = {0};          // String id i is arena_[string_offsets_[i] .. string_offsets_[i + 1])
+    std::vector<uint64_t> intern_buckets_;           // Build-time hash table of hash << 32 | id + 1 (0 = empty), cleared by finish()
+
+    Column<StringId> code_, title_, subject_, instructor_, description_;
+    Column<uint32_t> prereq_offsets_ = {0};          // Row r's prerequisites are prereq_codes_[prereq_offsets_[r] .. prereq_offsets_[r + 1])
+    Column<StringId> prereq_codes_;
+    Column<int32_t> seats_, capacity_;
+
+    std::shared_ptr<const MappedFile> snapshot_;     // Keeps the mapping alive while the columns view it
+};
+
+#endif // COURSE_TABLE_H
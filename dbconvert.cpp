@@ -0,0 +1,37 @@
+/*
+ * CS447 P1 Catalog Converter
+ * --------------------------
+ * Description: Converts a semicolon-separated courses.db into the binary snapshot the
+ *              server maps at startup instead of parsing the text file.
+ *
+ *      Build and run with:
+ *           make dbconvert
+ *           ./dbconvert [courses.db] [courses.snap]
+ */
+
+#include <cstdio>
+#include <string>
+#include "catalog.h"
+#include "p1_helper.h"
+using namespace std;
+
+int main(int argc, char *argv[])
+{
+  string database = argc > 1 ? argv[1] : "courses.db";
+  string snapshot = argc > 2 ? argv[2] : Catalog::snapshot_path(database);
+
+  CourseTable table = load_course_table(database);
+  if (table.size() == 0)
+  {
+    fprintf(stderr, "dbconvert: no courses loaded from %s\n", database.c_str());
+    return 1;
+  }
+  string error;
+  if (!table.write_snapshot(snapshot, error))
+  {
+    fprintf(stderr, "dbconvert: %s: %s\n", snapshot.c_str(), error.c_str());
+    return 1;
+  }
+  printf("dbconvert: wrote %zu courses (%zu strings) to %s\n", table.size(), table.string_count(), snapshot.c_str());
+  return 0;
+}
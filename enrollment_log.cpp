@@ -0,0 +1,589 @@
+/*
+ * ENROLLMENT LOG
+ * --------------
+ * Description: Group-committed write-ahead log that makes ENROLL and DROP survive a restart,
+ *              kept short by periodic checkpoints.
+ */
+#include "enrollment_log.h"
+#include "mapped_file.h"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fcntl.h>
+#include <iostream>
+#include <map>
+#include <unistd.h>
+#include <vector>
+
+static const char LOG_MAGIC[8] = {'C', 'R', 'S', 'W', 'A', 'L', '1', '\n'};
+static const char CHECKPOINT_MAGIC[8] = {'C', 'R', 'S', 'C', 'K', 'P', '1', '\n'};
+static const size_t CHECKPOINT_HEADER = sizeof CHECKPOINT_MAGIC + sizeof(uint64_t); // Magic, last segment covered
+static const size_t RECORD_HEADER = 8;                                               // uint32 payload length, uint32 CRC-32
+
+// CRC-32 (IEEE 802.3, reflected), table driven
+static uint32_t crc32(std::string_view data)
+{
+    static const std::array<uint32_t, 256> table = []
+    {
+        std::array<uint32_t, 256> entries{};
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++)
+            {
+                crc = (crc & 1) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+            }
+            entries[i] = crc;
+        }
+        return entries;
+    }();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (unsigned char c : data)
+    {
+        crc = table[(crc ^ c) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+static void put_u16(std::string &out, uint16_t value)
+{
+    out.append(reinterpret_cast<const char *>(&value), sizeof value);
+}
+
+static void put_u32(std::string &out, uint32_t value)
+{
+    out.append(reinterpret_cast<const char *>(&value), sizeof value);
+}
+
+template <typename T>
+static T get(const char *p)
+{
+    T value;
+    std::memcpy(&value, p, sizeof value);
+    return value;
+}
+
+// Decodes a record payload; false if its fields do not add up to the payload length
+static bool decode(std::string_view payload, EnrollmentLog::Op &op, std::string_view &student, std::string_view &course_code)
+{
+    if (payload.size() < 1 + 2 + 2 || (payload[0] != 'E' && payload[0] != 'D'))
+    {
+        return false;
+    }
+    op = static_cast<EnrollmentLog::Op>(payload[0]);
+    size_t student_length = get<uint16_t>(payload.data() + 1);
+    if (payload.size() < 1 + 2 + student_length + 2)
+    {
+        return false;
+    }
+    student = payload.substr(3, student_length);
+    size_t code_length = get<uint16_t>(payload.data() + 3 + student_length);
+    if (payload.size() != 1 + 2 + student_length + 2 + code_length)
+    {
+        return false;
+    }
+    course_code = payload.substr(5 + student_length, code_length);
+    return true;
+}
+
+static bool write_all(int fd, std::string_view data)
+{
+    while (!data.empty())
+    {
+        ssize_t written = write(fd, data.data(), data.size());
+        if (written == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        data.remove_prefix(written);
+    }
+    return true;
+}
+
+// Encodes one record, header included
+static void encode(std::string &out, EnrollmentLog::Op op, std::string_view student, std::string_view course_code)
+{
+    std::string payload;
+    payload.push_back(static_cast<char>(op));
+    put_u16(payload, static_cast<uint16_t>(std::min<size_t>(student.size(), UINT16_MAX)));
+    payload.append(student.substr(0, UINT16_MAX));
+    put_u16(payload, static_cast<uint16_t>(std::min<size_t>(course_code.size(), UINT16_MAX)));
+    payload.append(course_code.substr(0, UINT16_MAX));
+    put_u32(out, static_cast<uint32_t>(payload.size()));
+    put_u32(out, crc32(payload));
+    out += payload;
+}
+
+// Calls apply for every intact record in data, starting at offset; returns where the intact records end
+static size_t read_records(std::string_view data, size_t offset, const EnrollmentLog::Apply &apply)
+{
+    while (data.size() - offset >= RECORD_HEADER)
+    {
+        uint32_t length = get<uint32_t>(data.data() + offset);
+        uint32_t checksum = get<uint32_t>(data.data() + offset + 4);
+        if (length > data.size() - offset - RECORD_HEADER)
+        {
+            break;
+        }
+        std::string_view payload = data.substr(offset + RECORD_HEADER, length);
+        EnrollmentLog::Op op;
+        std::string_view student, course_code;
+        if (crc32(payload) != checksum || !decode(payload, op, student, course_code))
+        {
+            break;
+        }
+        apply(op, student, course_code);
+        offset += RECORD_HEADER + length;
+    }
+    return offset;
+}
+
+// Makes a file's creation, rename or removal durable
+static void sync_directory(const std::string &path)
+{
+    std::filesystem::path directory = std::filesystem::path(path).parent_path();
+    int fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd != -1)
+    {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+// Writes a whole file under a temporary name, syncs it and renames it into place
+static bool write_file_atomically(const std::string &path, std::string_view contents, std::string &error)
+{
+    std::string temporary = path + ".tmp";
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == -1 || !write_all(fd, contents) || fsync(fd) == -1)
+    {
+        error = std::strerror(errno);
+        if (fd != -1)
+        {
+            close(fd);
+            unlink(temporary.c_str());
+        }
+        return false;
+    }
+    close(fd);
+    if (rename(temporary.c_str(), path.c_str()) == -1)
+    {
+        error = std::strerror(errno);
+        unlink(temporary.c_str());
+        return false;
+    }
+    sync_directory(path);
+    return true;
+}
+
+// Creates a new, empty segment ready for appending; returns its descriptor or -1
+static int create_segment(const std::string &path, std::string &error)
+{
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_APPEND | O_CLOEXEC, 0644);
+    if (fd == -1 || !write_all(fd, std::string_view(LOG_MAGIC, sizeof LOG_MAGIC)) || fsync(fd) == -1)
+    {
+        error = std::strerror(errno);
+        if (fd != -1)
+        {
+            close(fd);
+        }
+        return -1;
+    }
+    sync_directory(path);
+    return fd;
+}
+
+// The numbers of the segments of the log at path, in ascending order
+static std::vector<uint64_t> list_segments(const std::string &path)
+{
+    std::filesystem::path base(path);
+    std::filesystem::path directory = base.parent_path().empty() ? "." : base.parent_path();
+    std::string prefix = base.filename().string() + ".";
+    std::vector<uint64_t> segments;
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator(directory, error))
+    {
+        std::string name = entry.path().filename().string();
+        if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0)
+        {
+            continue;
+        }
+        std::string number = name.substr(prefix.size());
+        if (number.find_first_not_of("0123456789") == std::string::npos)
+        {
+            segments.push_back(std::stoull(number));
+        }
+    }
+    std::sort(segments.begin(), segments.end());
+    return segments;
+}
+
+std::string EnrollmentLog::segment_path(uint64_t segment) const
+{
+    char suffix[32];
+    snprintf(suffix, sizeof suffix, ".%06llu", static_cast<unsigned long long>(segment));
+    return path_ + suffix;
+}
+
+std::string EnrollmentLog::checkpoint_path() const
+{
+    return path_ + ".ckpt";
+}
+
+// Replays one segment; a torn tail is reported and cut off
+static bool replay_segment(const std::string &path, const EnrollmentLog::Apply &apply, std::string &error)
+{
+    MappedFile file;
+    if (!file.open(path, error))
+    {
+        return false;
+    }
+    std::string_view data = file.data();
+    if (data.size() < sizeof LOG_MAGIC || std::memcmp(data.data(), LOG_MAGIC, sizeof LOG_MAGIC) != 0)
+    {
+        error = path + " is not an enrollment log";
+        return false;
+    }
+    size_t end = read_records(data, sizeof LOG_MAGIC, apply);
+    if (end < data.size())
+    {
+        std::cerr << "Error: " << path << ": discarding " << data.size() - end << " bytes of torn records at the end of the log" << std::endl;
+        if (truncate(path.c_str(), end) == -1)
+        {
+            error = std::strerror(errno);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Replays a checkpoint and reports the last segment it covers; a missing checkpoint covers nothing
+static bool replay_checkpoint(const std::string &path, const EnrollmentLog::Apply &apply, bool &found, uint64_t &covered, std::string &error)
+{
+    found = false;
+    covered = 0;
+    if (!std::filesystem::exists(path))
+    {
+        return true;
+    }
+    MappedFile file;
+    if (!file.open(path, error))
+    {
+        return false;
+    }
+    std::string_view data = file.data();
+    if (data.size() < CHECKPOINT_HEADER || std::memcmp(data.data(), CHECKPOINT_MAGIC, sizeof CHECKPOINT_MAGIC) != 0)
+    {
+        error = path + " is not an enrollment checkpoint";
+        return false;
+    }
+    // Checkpoints are renamed into place whole, so a bad record means corruption, not a crash
+    if (read_records(data, CHECKPOINT_HEADER, apply) != data.size())
+    {
+        error = path + " is corrupt";
+        return false;
+    }
+    found = true;
+    covered = get<uint64_t>(data.data() + sizeof CHECKPOINT_MAGIC);
+    return true;
+}
+
+EnrollmentLog::~EnrollmentLog()
+{
+    {
+        std::lock_guard guard(lock_);
+        checkpoints_stopping_ = true;
+    }
+    stop_checkpoints_.notify_all();
+    if (checkpointer_.joinable())
+    {
+        checkpointer_.join();
+    }
+    {
+        std::lock_guard guard(lock_);
+        stopping_ = true;
+    }
+    appended_.notify_one();
+    if (flusher_.joinable())
+    {
+        flusher_.join();
+    }
+    if (fd_ != -1)
+    {
+        close(fd_);
+    }
+}
+
+bool EnrollmentLog::open(const std::string &path, std::chrono::microseconds commit_window, std::chrono::seconds checkpoint_interval,
+                         const Apply &apply, std::string &error)
+{
+    path_ = path;
+
+    bool found = false;
+    uint64_t covered = 0;
+    if (!replay_checkpoint(checkpoint_path(), apply, found, covered, error))
+    {
+        return false;
+    }
+
+    // A log written before segments existed becomes segment 0
+    std::error_code ignored;
+    if (std::filesystem::is_regular_file(path_, ignored) && rename(path_.c_str(), segment_path(0).c_str()) == -1)
+    {
+        error = std::strerror(errno);
+        return false;
+    }
+
+    uint64_t last = covered;
+    for (uint64_t segment : list_segments(path_))
+    {
+        if (found && segment <= covered)
+        {
+            // Already folded into the checkpoint; left behind by a crash before it was deleted
+            unlink(segment_path(segment).c_str());
+            continue;
+        }
+        if (!replay_segment(segment_path(segment), apply, error))
+        {
+            return false;
+        }
+        last = std::max(last, segment);
+        if (std::filesystem::file_size(segment_path(segment), ignored) == sizeof LOG_MAGIC)
+        {
+            unlink(segment_path(segment).c_str()); // Nothing in it, so nothing to keep for the next checkpoint
+        }
+    }
+
+    // Never append to a segment that was replayed, so a torn tail can only ever be in the newest one
+    segment_ = last + 1;
+    fd_ = create_segment(segment_path(segment_), error);
+    if (fd_ == -1)
+    {
+        return false;
+    }
+    commit_window_ = commit_window;
+    flusher_ = std::jthread([this]
+                            { flush_loop(); });
+    if (checkpoint_interval.count() > 0)
+    {
+        checkpointer_ = std::jthread([this, checkpoint_interval]
+                                     { checkpoint_loop(checkpoint_interval); });
+    }
+    return true;
+}
+
+bool EnrollmentLog::append(Op op, std::string_view student, std::string_view course_code)
+{
+    std::string record;
+    encode(record, op, student, course_code);
+
+    std::unique_lock guard(lock_);
+    if (fd_ == -1 || failed_)
+    {
+        return false;
+    }
+    bool first = pending_.empty();
+    pending_ += record;
+    uint64_t sequence = ++next_sequence_;
+    segment_records_++;
+    if (first)
+    {
+        appended_.notify_one();
+    }
+    synced_.wait(guard, [&]
+                 { return durable_sequence_ >= sequence; });
+    return !failed_;
+}
+
+void EnrollmentLog::flush_loop()
+{
+    std::unique_lock guard(lock_);
+    while (true)
+    {
+        appended_.wait(guard, [&]
+                       { return !pending_.empty() || rotate_requested_ || stopping_; });
+        if (pending_.empty() && !rotate_requested_)
+        {
+            return; // Stopping with nothing left to write
+        }
+
+        if (!pending_.empty())
+        {
+            if (commit_window_.count() > 0 && !stopping_ && !rotate_requested_)
+            {
+                // Give other sessions the rest of the window to join this batch
+                appended_.wait_for(guard, commit_window_, [&]
+                                   { return stopping_ || rotate_requested_; });
+            }
+
+            std::string batch;
+            batch.swap(pending_);
+            uint64_t last = next_sequence_;
+            bool ok = !failed_;
+            guard.unlock();
+            if (ok)
+            {
+                ok = write_all(fd_, batch) && fdatasync(fd_) == 0;
+                if (!ok)
+                {
+                    perror("enrollment log");
+                }
+            }
+            guard.lock();
+            failed_ = failed_ || !ok;
+            durable_sequence_ = last;
+            batches_++;
+        }
+
+        if (rotate_requested_)
+        {
+            // Between two batches, so every record up to here is in the old segment and durable
+            std::string error;
+            guard.unlock();
+            int fd = create_segment(segment_path(segment_ + 1), error);
+            guard.lock();
+            if (fd != -1)
+            {
+                close(fd_);
+                fd_ = fd;
+                segment_++;
+                segment_records_ = 0;
+            }
+            else
+            {
+                std::cerr << "Error: cannot start enrollment log segment " << segment_path(segment_ + 1) << ": " << error << std::endl;
+            }
+            rotate_requested_ = false;
+        }
+        synced_.notify_all();
+    }
+}
+
+bool EnrollmentLog::checkpoint()
+{
+    std::lock_guard checkpointing(checkpoint_lock_);
+
+    // Close the current segment so that everything up to it is immutable
+    uint64_t covered;
+    {
+        std::unique_lock guard(lock_);
+        if (fd_ == -1 || failed_ || checkpoints_stopping_)
+        {
+            return false;
+        }
+        if (segment_records_ == 0)
+        {
+            covered = segment_ - 1; // Nothing to rotate away, but segments replayed at startup may still need folding
+        }
+        else
+        {
+            covered = segment_;
+            rotate_requested_ = true;
+            appended_.notify_one();
+            synced_.wait(guard, [&]
+                         { return !rotate_requested_; });
+            if (segment_ == covered)
+            {
+                return false; // Could not rotate
+            }
+        }
+    }
+
+    // Fold the previous checkpoint and the closed segments into each student's current courses
+    std::map<std::string, std::vector<std::string>, std::less<>> enrolled;
+    auto fold = [&](Op op, std::string_view student, std::string_view course_code)
+    {
+        std::vector<std::string> &courses = enrolled[std::string(student)];
+        auto found = std::find(courses.begin(), courses.end(), course_code);
+        if (op == Op::Enroll && found == courses.end())
+        {
+            courses.emplace_back(course_code);
+        }
+        else if (op == Op::Drop && found != courses.end())
+        {
+            courses.erase(found);
+        }
+    };
+    std::string error;
+    bool found = false;
+    uint64_t previous = 0;
+    if (!replay_checkpoint(checkpoint_path(), fold, found, previous, error))
+    {
+        std::cerr << "Error: checkpoint skipped: " << error << std::endl;
+        return false;
+    }
+    std::vector<uint64_t> folded;
+    for (uint64_t segment : list_segments(path_))
+    {
+        if (segment > covered || (found && segment <= previous))
+        {
+            continue;
+        }
+        if (!replay_segment(segment_path(segment), fold, error))
+        {
+            std::cerr << "Error: checkpoint skipped: " << error << std::endl;
+            return false;
+        }
+        folded.push_back(segment);
+    }
+    if (folded.empty())
+    {
+        return false;
+    }
+
+    std::string contents(CHECKPOINT_MAGIC, sizeof CHECKPOINT_MAGIC);
+    contents.append(reinterpret_cast<const char *>(&covered), sizeof covered);
+    size_t records = 0;
+    for (const auto &[student, courses] : enrolled)
+    {
+        for (const std::string &course_code : courses)
+        {
+            encode(contents, Op::Enroll, student, course_code);
+            records++;
+        }
+    }
+    if (!write_file_atomically(checkpoint_path(), contents, error))
+    {
+        std::cerr << "Error: cannot write checkpoint " << checkpoint_path() << ": " << error << std::endl;
+        return false;
+    }
+
+    // The checkpoint is durable, so the segments it covers can go
+    for (uint64_t segment : folded)
+    {
+        unlink(segment_path(segment).c_str());
+    }
+    sync_directory(path_);
+    std::cout << "server: checkpointed " << records << " enrollment(s) through log segment " << covered << ", removed " << folded.size() << " segment(s)" << std::endl;
+    return true;
+}
+
+void EnrollmentLog::checkpoint_loop(std::chrono::seconds interval)
+{
+    std::unique_lock guard(lock_);
+    while (!stop_checkpoints_.wait_for(guard, interval, [&]
+                                       { return checkpoints_stopping_; }))
+    {
+        guard.unlock();
+        checkpoint();
+        guard.lock();
+    }
+}
+
+uint64_t EnrollmentLog::records_synced() const
+{
+    std::lock_guard guard(lock_);
+    return durable_sequence_;
+}
+
+uint64_t EnrollmentLog::batches_synced() const
+{
+    std::lock_guard guard(lock_);
+    return batches_;
+}
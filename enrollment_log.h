@@ -0,0 +1,119 @@
+#ifndef ENROLLMENT_LOG_H
+#define ENROLLMENT_LOG_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+/**
+ * @class EnrollmentLog
+ * @brief An append-only, group-committed write-ahead log of ENROLL and DROP, with checkpoints.
+ *
+ * append() blocks until its record is on disk, but records are not synced one by
+ * one: a flusher thread collects everything appended during the commit window
+ * (and while the previous sync was running) and makes the whole batch durable
+ * with one write and one fdatasync. Concurrent ENROLLs therefore share a sync.
+ *
+ * The log for path P is a series of numbered segments, P.000001, P.000002, ...,
+ * plus a checkpoint P.ckpt. A checkpoint rotates to a fresh segment (a pointer
+ * swap between two batches, so appends never wait for it), then folds the old
+ * checkpoint and the closed segments into a new one on a background thread and
+ * deletes those segments. The fold only reads closed files, never live state.
+ * Opening the log loads the checkpoint and replays only the segments after it.
+ *
+ * Segments and checkpoints share one record format: an 8-byte magic
+ * ("CRSWAL1\n" for a segment, "CRSCKP1\n" followed by the uint64 number of the
+ * last segment it covers for a checkpoint), then records, each a uint32
+ * payload length, a uint32 CRC-32 of the payload, and the payload (op byte,
+ * uint16-length-prefixed student, uint16-length-prefixed course code). A record
+ * whose length or checksum does not match (a write torn by a crash) ends the file.
+ * A checkpoint holds one Enroll record per course a student is enrolled in.
+ */
+class EnrollmentLog
+{
+public:
+    enum class Op : uint8_t
+    {
+        Enroll = 'E',
+        Drop = 'D'
+    };
+
+    using Apply = std::function<void(Op op, std::string_view student, std::string_view course_code)>;
+
+    EnrollmentLog() = default;
+    ~EnrollmentLog();
+    EnrollmentLog(const EnrollmentLog &) = delete;
+    EnrollmentLog &operator=(const EnrollmentLog &) = delete;
+
+    /**
+     * @brief Loads the checkpoint and replays the segments after it, then opens a new segment for appending.
+     *
+     * A torn tail is reported and cut off. A single-file log from before segments
+     * (the file at path itself) is taken over as segment 0.
+     * @param path The log's base path; segments and the checkpoint are named after it.
+     * @param commit_window How long the flusher waits for more records before syncing a batch.
+     * @param checkpoint_interval How often to checkpoint; zero turns periodic checkpoints off.
+     * @param apply Called for every record in the checkpoint and the segments, in order.
+     * @param error Set to a description of the failure when false is returned.
+     * @return true if the log is open.
+     */
+    bool open(const std::string &path, std::chrono::microseconds commit_window, std::chrono::seconds checkpoint_interval,
+              const Apply &apply, std::string &error);
+
+    /**
+     * @brief Appends a record and waits until it is durable.
+     * @return false if the log could not be written; the record may then be lost.
+     */
+    bool append(Op op, std::string_view student, std::string_view course_code);
+
+    /**
+     * @brief Writes a checkpoint of everything logged so far and deletes the segments it covers.
+     *
+     * Runs on the caller's thread; appends carry on while it works.
+     * @return false if there was nothing new to checkpoint or it failed.
+     */
+    bool checkpoint();
+
+    bool is_open() const { return fd_ != -1; }
+
+    /**
+     * @brief Records and batches made durable so far, for reports on how well commits are grouped.
+     */
+    uint64_t records_synced() const;
+    uint64_t batches_synced() const;
+
+private:
+    void flush_loop();
+    void checkpoint_loop(std::chrono::seconds interval);
+    std::string segment_path(uint64_t segment) const;
+    std::string checkpoint_path() const;
+
+    std::string path_;
+    int fd_ = -1;
+    uint64_t segment_ = 0;              // The segment fd_ appends to
+    std::chrono::microseconds commit_window_{0};
+
+    mutable std::mutex lock_;
+    std::condition_variable appended_;  // Signalled when pending_ gets its first record, a rotation is requested, or on shutdown
+    std::condition_variable synced_;    // Signalled after every batch and rotation
+    std::string pending_;               // Encoded records waiting for the next batch
+    uint64_t next_sequence_ = 0;        // Sequence number of the last appended record
+    uint64_t durable_sequence_ = 0;     // Every record up to this one is on disk
+    uint64_t segment_records_ = 0;      // Records appended to the current segment
+    uint64_t batches_ = 0;
+    bool rotate_requested_ = false;
+    bool failed_ = false;               // A write or sync failed; every later append fails too
+    bool stopping_ = false;
+    std::mutex checkpoint_lock_;        // One checkpoint at a time
+    std::condition_variable stop_checkpoints_;
+    bool checkpoints_stopping_ = false; // Set first on shutdown, so a checkpoint never waits on a stopped flusher
+    std::jthread flusher_;
+    std::jthread checkpointer_;
+};
+
+#endif // ENROLLMENT_LOG_H
@@ -0,0 +1,310 @@
+/*
+ * EVENT LOOP
+ * ----------
+ * Description: epoll based reactors that drive non-blocking client sockets, used when
+ *              server.conf selects IO_MODE=epoll instead of one thread per client.
+ */
+#include "event_loop.h"
+#include <iostream>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+
+#define RECV_CHUNK 4096
+#define MAXEVENTS 64
+
+// Back-pressure thresholds: stop reading from a client above the high mark, resume below the low one
+#define OUTPUT_HIGH_WATER (1024 * 1024)
+#define OUTPUT_LOW_WATER (256 * 1024)
+#define PENDING_HIGH_WATER 1024
+#define PENDING_LOW_WATER 256
+
+EventLoop::Connection::~Connection()
+{
+    close(session.fd);
+    std::cout << "server: connection with " << session.peer << " closed." << std::endl;
+}
+
+EventLoop::EventLoop(int threads, MessageHandler handler, ThreadPool *workers)
+    : handler_(std::move(handler)), workers_(workers),
+      // One pool size class that fits a Connection together with its shared_ptr control block
+      connection_pool_(std::pmr::pool_options{0, sizeof(Connection) + 128})
+{
+    if (threads < 1)
+    {
+        threads = 1;
+    }
+    for (int i = 0; i < threads; i++)
+    {
+        auto reactor = std::make_unique<Reactor>();
+        reactor->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        reactor->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (reactor->epoll_fd == -1 || reactor->wake_fd == -1)
+        {
+            perror("epoll");
+            exit(1);
+        }
+
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.ptr = nullptr; // A null pointer marks the wake-up eventfd
+        epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, reactor->wake_fd, &ev);
+
+        Reactor &ref = *reactor;
+        reactor->thread = std::jthread([this, &ref](std::stop_token stop)
+                                       { run(ref, stop); });
+        reactors_.push_back(std::move(reactor));
+    }
+}
+
+EventLoop::~EventLoop()
+{
+    for (auto &reactor : reactors_)
+    {
+        reactor->thread.request_stop();
+        uint64_t one = 1;
+        if (write(reactor->wake_fd, &one, sizeof one) == -1)
+        {
+            perror("eventfd write");
+        }
+        reactor->thread.join();
+        close(reactor->wake_fd);
+        close(reactor->epoll_fd);
+        reactor->connections.clear();
+    }
+}
+
+void EventLoop::add_connection(int fd, const std::string &peer)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1)
+    {
+        perror("fcntl");
+        close(fd);
+        return;
+    }
+
+    Reactor &reactor = *reactors_[next_reactor_.fetch_add(1, std::memory_order_relaxed) % reactors_.size()];
+    auto connection = std::allocate_shared<Connection>(std::pmr::polymorphic_allocator<Connection>(&connection_pool_));
+    connection->session.fd = fd;
+    connection->session.peer = peer;
+    connection->epoll_fd = reactor.epoll_fd;
+    connection->interest = EPOLLIN | EPOLLRDHUP;
+    {
+        std::lock_guard guard(reactor.lock);
+        reactor.connections[connection.get()] = connection;
+    }
+
+    struct epoll_event ev = {};
+    ev.events = connection->interest;
+    ev.data.ptr = connection.get();
+    if (epoll_ctl(reactor.epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1)
+    {
+        perror("epoll_ctl");
+        std::lock_guard guard(reactor.lock);
+        reactor.connections.erase(connection.get());
+    }
+}
+
+void EventLoop::close_connection(Reactor &reactor, Connection *connection)
+{
+    epoll_ctl(reactor.epoll_fd, EPOLL_CTL_DEL, connection->session.fd, nullptr);
+    {
+        std::lock_guard guard(connection->lock);
+        connection->closed = true;
+        connection->pending.clear();
+        connection->outbound.clear();
+    }
+    // A worker may still hold a reference; the socket is closed when the last one goes
+    std::lock_guard guard(reactor.lock);
+    reactor.connections.erase(connection);
+}
+
+void EventLoop::update_interest(Connection &connection)
+{
+    // Stop reading from a client that does not read its replies or floods us with
+    // commands, and resume once it has caught up (hysteresis avoids flapping)
+    bool paused = !(connection.interest & EPOLLIN);
+    size_t backlog = connection.outbound.pending_bytes();
+    if (paused)
+    {
+        paused = backlog > OUTPUT_LOW_WATER || connection.pending.size() > PENDING_LOW_WATER;
+    }
+    else
+    {
+        paused = backlog > OUTPUT_HIGH_WATER || connection.pending.size() > PENDING_HIGH_WATER;
+    }
+
+    uint32_t interest = 0;
+    if (!paused && !connection.closed)
+    {
+        interest |= EPOLLIN | EPOLLRDHUP;
+    }
+    if (!connection.outbound.empty())
+    {
+        interest |= EPOLLOUT;
+    }
+    if (interest == connection.interest)
+    {
+        return;
+    }
+
+    connection.interest = interest;
+    struct epoll_event ev = {};
+    ev.events = interest;
+    ev.data.ptr = &connection;
+    epoll_ctl(connection.epoll_fd, EPOLL_CTL_MOD, connection.session.fd, &ev);
+}
+
+void EventLoop::write_outbound(Connection &connection)
+{
+    // Called with connection.lock held
+    if (connection.outbound.flush(connection.session.fd) == OutputQueue::FlushResult::Error)
+    {
+        connection.closed = true;
+        connection.pending.clear();
+        connection.outbound.clear();
+    }
+    if (connection.closed && connection.outbound.empty())
+    {
+        // The reactor sees the hang-up and drops the connection
+        shutdown(connection.session.fd, SHUT_RDWR);
+    }
+    update_interest(connection);
+}
+
+void EventLoop::deliver(Connection &connection)
+{
+    // Called with connection.lock held, by whichever thread just ran the handler
+    connection.outbound.append(connection.session.out);
+    write_outbound(connection);
+}
+
+void EventLoop::dispatch(const std::shared_ptr<Connection> &connection, std::string message)
+{
+    std::lock_guard guard(connection->lock);
+    if (connection->closed)
+    {
+        return;
+    }
+    connection->pending.push_back(std::move(message));
+    if (!connection->scheduled)
+    {
+        connection->scheduled = true;
+        workers_->submit([this, connection]
+                         { drain(connection); });
+    }
+    update_interest(*connection);
+}
+
+void EventLoop::drain(const std::shared_ptr<Connection> &connection)
+{
+    while (true)
+    {
+        std::string message;
+        {
+            std::lock_guard guard(connection->lock);
+            // Hand over large replies early instead of holding them until the batch ends
+            if (connection->session.out.pending_bytes() > OUTPUT_LOW_WATER)
+            {
+                deliver(*connection);
+            }
+            if (connection->closed || connection->pending.empty())
+            {
+                deliver(*connection);
+                connection->scheduled = false;
+                return;
+            }
+            message = std::move(connection->pending.front());
+            connection->pending.pop_front();
+        }
+
+        if (handler_(connection->session, message) == 0)
+        {
+            std::lock_guard guard(connection->lock);
+            connection->closed = true;
+            connection->pending.clear();
+        }
+    }
+}
+
+void EventLoop::run(Reactor &reactor, std::stop_token stop)
+{
+    struct epoll_event events[MAXEVENTS];
+    std::string line;
+
+    while (!stop.stop_requested())
+    {
+        int ready = epoll_wait(reactor.epoll_fd, events, MAXEVENTS, -1);
+        if (ready == -1)
+        {
+            if (errno != EINTR)
+            {
+                perror("epoll_wait");
+            }
+            continue;
+        }
+
+        for (int i = 0; i < ready; i++)
+        {
+            Connection *connection = static_cast<Connection *>(events[i].data.ptr);
+            if (connection == nullptr)
+            {
+                continue; // Woken up to check the stop token
+            }
+
+            if (events[i].events & EPOLLOUT)
+            {
+                std::lock_guard guard(connection->lock);
+                write_outbound(*connection);
+            }
+            if (!(events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)))
+            {
+                continue;
+            }
+
+            int numbytes = recv(connection->session.fd, connection->input.prepare(RECV_CHUNK), RECV_CHUNK, 0);
+            if (numbytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+            {
+                continue;
+            }
+            if (numbytes <= 0)
+            {
+                if (numbytes < 0 && errno != ECONNRESET && errno != ENOTCONN)
+                {
+                    perror("recv");
+                }
+                close_connection(reactor, connection);
+                continue;
+            }
+            connection->input.commit(numbytes);
+
+            if (workers_ != nullptr)
+            {
+                std::shared_ptr<Connection> owner;
+                {
+                    std::lock_guard guard(reactor.lock);
+                    owner = reactor.connections[connection];
+                }
+                while (next_message(connection->input, connection->session, line))
+                {
+                    dispatch(owner, line);
+                }
+                continue;
+            }
+
+            while (!connection->closed && next_message(connection->input, connection->session, line))
+            {
+                if (handler_(connection->session, line) == 0)
+                {
+                    connection->closed = true;
+                }
+            }
+            std::lock_guard guard(connection->lock);
+            deliver(*connection);
+        }
+    }
+}
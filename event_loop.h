@@ -0,0 +1,112 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "line_buffer.h"
+#include "output_queue.h"
+#include "session.h"
+#include "thread_pool.h"
+
+/**
+ * @class EventLoop
+ * @brief Multiplexes every client socket over a small, fixed set of epoll reactor threads.
+ *
+ * Accepted sockets are switched to non-blocking mode and handed to the reactors
+ * round-robin. Each reactor waits on its own epoll instance and passes every
+ * complete line it reads to the handler, so idle clients cost a Session and not a thread.
+ *
+ * When a worker pool is given, reactors only do I/O: messages are queued on their
+ * connection and run as pool tasks, one task per connection at a time, so each
+ * client's replies still go out in the order its commands arrived.
+ *
+ * Replies collect in the connection's OutputQueue and are written with writev.
+ * Whatever the socket does not take waits for EPOLLOUT, and a client with too
+ * much unread output or too many queued commands is not read from until it
+ * catches up.
+ *
+ * Connections are carved out of a slab pool owned by the event loop, so the
+ * memory of a closed connection goes to the next one accepted instead of back
+ * to the general heap.
+ */
+class EventLoop
+{
+public:
+    /**
+     * @brief Called with every message read from a client.
+     * @return 0 to close the connection, anything else to keep it open.
+     */
+    using MessageHandler = std::function<int(Session &, const std::string &)>;
+
+    /**
+     * @brief Starts the reactor threads.
+     * @param threads The number of reactor threads (at least one is started).
+     * @param handler The function that processes each received message.
+     * @param workers The pool that runs the handler, or nullptr to run it on the reactor thread.
+     */
+    EventLoop(int threads, MessageHandler handler, ThreadPool *workers = nullptr);
+
+    /**
+     * @brief Stops and joins the reactor threads.
+     */
+    ~EventLoop();
+
+    EventLoop(const EventLoop &) = delete;
+    EventLoop &operator=(const EventLoop &) = delete;
+
+    /**
+     * @brief Hands a freshly accepted socket to one of the reactors.
+     * @param fd The accepted socket; the event loop takes ownership of it.
+     * @param peer The client's IP address string.
+     */
+    void add_connection(int fd, const std::string &peer);
+
+private:
+    struct Connection
+    {
+        ~Connection();
+
+        Session session;
+        LineBuffer input;                 // Only touched by the reactor thread
+        int epoll_fd = -1;                // The owning reactor's epoll instance
+        std::mutex lock;                  // Guards the fields below
+        std::deque<std::string> pending;  // Messages waiting for a worker
+        OutputQueue outbound;             // Replies not yet accepted by the socket
+        uint32_t interest = 0;            // The epoll events currently registered
+        bool scheduled = false;           // A drain task is queued or running
+        bool closed = false;              // No more commands; shut down once outbound is written
+    };
+
+    struct Reactor
+    {
+        int epoll_fd = -1;
+        int wake_fd = -1; // eventfd used to interrupt epoll_wait on shutdown
+        std::mutex lock;  // Guards connections, which add_connection fills from the accept thread
+        std::unordered_map<Connection *, std::shared_ptr<Connection>> connections;
+        std::jthread thread;
+    };
+
+    void run(Reactor &reactor, std::stop_token stop);
+    void dispatch(const std::shared_ptr<Connection> &connection, std::string message);
+    void drain(const std::shared_ptr<Connection> &connection);
+    void deliver(Connection &connection);
+    void write_outbound(Connection &connection);
+    void update_interest(Connection &connection);
+    void close_connection(Reactor &reactor, Connection *connection);
+
+    MessageHandler handler_;
+    ThreadPool *workers_;
+    std::pmr::synchronized_pool_resource connection_pool_; // Declared before reactors_, whose connections live in it
+    std::vector<std::unique_ptr<Reactor>> reactors_;
+    std::atomic<size_t> next_reactor_{0};
+};
+
+#endif // EVENT_LOOP_H
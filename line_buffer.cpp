@@ -0,0 +1,134 @@
+/*
+ * LINE BUFFER
+ * -----------
+ * Description: Splits a client's byte stream into command lines, keeping partial tails.
+ */
+#include "line_buffer.h"
+#include <algorithm>
+#include <cstring>
+
+LineBuffer::LineBuffer(size_t max_line) : max_line_(max_line)
+{
+}
+
+char *LineBuffer::prepare(size_t min_free)
+{
+    if (data_.size() - end_ < min_free)
+    {
+        // Slide the unread bytes to the front before deciding to grow
+        if (start_ > 0)
+        {
+            std::memmove(data_.data(), data_.data() + start_, end_ - start_);
+            end_ -= start_;
+            start_ = 0;
+        }
+        if (data_.size() - end_ < min_free)
+        {
+            data_.resize(std::max(data_.size() * 2, end_ + min_free));
+        }
+    }
+    return data_.data() + end_;
+}
+
+void LineBuffer::commit(size_t n)
+{
+    end_ += n;
+}
+
+bool LineBuffer::next_line(std::string &line)
+{
+    while (true)
+    {
+        const char *begin = data_.data() + start_;
+        const char *newline = static_cast<const char *>(std::memchr(begin + scanned_, '\n', end_ - start_ - scanned_));
+        if (newline == nullptr)
+        {
+            scanned_ = end_ - start_;
+            if (scanned_ <= max_line_)
+            {
+                return false;
+            }
+            // Never buffer an unbounded line: reject it at once and skip the rest as it arrives
+            bool skip = discarding_;
+            discarding_ = true;
+            line.assign(TOO_LONG);
+            start_ = end_ = scanned_ = 0;
+            if (skip)
+            {
+                continue;
+            }
+            return true;
+        }
+
+        size_t length = newline - begin;
+        start_ += length + 1;
+        scanned_ = 0;
+        if (discarding_)
+        {
+            discarding_ = false;
+            continue;
+        }
+        if (length > 0 && begin[length - 1] == '\r')
+        {
+            length--;
+        }
+        if (length > max_line_)
+        {
+            line.assign(TOO_LONG);
+        }
+        else
+        {
+            line.assign(begin, length);
+        }
+        if (start_ == end_)
+        {
+            start_ = end_ = 0;
+        }
+        return true;
+    }
+}
+
+bool LineBuffer::next_frame(std::string &frame)
+{
+    if (skipping_ > 0)
+    {
+        size_t skipped = std::min(skipping_, end_ - start_);
+        start_ += skipped;
+        skipping_ -= skipped;
+        if (skipping_ > 0)
+        {
+            start_ = end_ = 0;
+            return false;
+        }
+    }
+    if (end_ - start_ < 4)
+    {
+        return false;
+    }
+    const unsigned char *header = reinterpret_cast<const unsigned char *>(data_.data() + start_);
+    size_t length = size_t(header[0]) << 24 | size_t(header[1]) << 16 | size_t(header[2]) << 8 | header[3];
+    if (length > max_line_)
+    {
+        // Drop whatever part of it is already here and the rest as it arrives
+        size_t skipped = std::min(length, end_ - start_ - 4);
+        start_ += 4 + skipped;
+        skipping_ = length - skipped;
+        if (start_ == end_)
+        {
+            start_ = end_ = 0;
+        }
+        frame.clear();
+        return true;
+    }
+    if (end_ - start_ - 4 < length)
+    {
+        return false;
+    }
+    frame.assign(data_.data() + start_ + 4, length);
+    start_ += 4 + length;
+    if (start_ == end_)
+    {
+        start_ = end_ = 0;
+    }
+    return true;
+}
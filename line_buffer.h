@@ -0,0 +1,74 @@
+#ifndef LINE_BUFFER_H
+#define LINE_BUFFER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class LineBuffer
+ * @brief A growable per-connection receive buffer that splits the byte stream into lines.
+ *
+ * Bytes are received straight into the buffer, every complete line ("\n" or "\r\n"
+ * terminated) is handed out in order, and a partial tail is kept until the rest
+ * of it arrives. This lets clients pipeline many commands in one segment and
+ * lets a command arrive split across several segments. After a connection
+ * switches to the binary protocol the same buffer hands out length-prefixed
+ * frames instead (see binary_protocol.h).
+ */
+class LineBuffer
+{
+public:
+    /**
+     * @brief What next_line() hands out in place of a line longer than max_line: a lone NUL byte,
+     *        which no valid command is. The session answers it with a 400 instead of running it.
+     */
+    static constexpr std::string_view TOO_LONG{"\0", 1};
+
+    /**
+     * @param max_line The longest line accepted; longer lines are handed out as TOO_LONG.
+     */
+    explicit LineBuffer(size_t max_line = 64 * 1024);
+
+    /**
+     * @brief Makes room for at least min_free more bytes.
+     * @return Where to receive into; call commit() with the number of bytes written.
+     */
+    char *prepare(size_t min_free);
+
+    /**
+     * @brief Marks n bytes written after prepare() as received.
+     */
+    void commit(size_t n);
+
+    /**
+     * @brief Takes the next complete line out of the buffer, without its line ending.
+     *
+     * A line longer than max_line is handed out once as TOO_LONG, as soon as it
+     * gets that long, and the rest of it is dropped as it arrives.
+     * @param line Receives the line.
+     * @return true if a line was available, false if only a partial line (or nothing) remains.
+     */
+    bool next_line(std::string &line);
+
+    /**
+     * @brief Takes the next complete frame out of the buffer, without its length prefix.
+     *
+     * A frame longer than max_line is skipped as it arrives and handed out empty,
+     * which no valid request is.
+     * @param frame Receives the frame.
+     * @return true if a frame was available, false if only part of one (or nothing) remains.
+     */
+    bool next_frame(std::string &frame);
+
+private:
+    std::vector<char> data_;
+    size_t start_ = 0;   // First byte not yet handed out
+    size_t end_ = 0;     // One past the last received byte
+    size_t scanned_ = 0; // Bytes after start_ already known to hold no newline
+    size_t max_line_;
+    bool discarding_ = false; // Dropping the rest of an over-long line
+    size_t skipping_ = 0;     // Bytes of an over-long frame still to drop
+};
+
+#endif // LINE_BUFFER_H
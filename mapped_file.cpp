@@ -0,0 +1,78 @@
+/*
+ * MAPPED FILE
+ * -----------
+ * Description: RAII wrapper around mmap for reading the catalog files in place.
+ */
+#include "mapped_file.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : address_(std::exchange(other.address_, nullptr)), size_(std::exchange(other.size_, 0))
+{
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        address_ = std::exchange(other.address_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+bool MappedFile::open(const std::string &filename, std::string &error)
+{
+    close();
+    int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        error = std::strerror(errno);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == -1)
+    {
+        error = std::strerror(errno);
+        ::close(fd);
+        return false;
+    }
+    if (info.st_size > 0)
+    {
+        void *address = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED)
+        {
+            error = std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+        // The loaders read front to back, so let the kernel read ahead aggressively
+        madvise(address, info.st_size, MADV_SEQUENTIAL);
+        address_ = address;
+        size_ = info.st_size;
+    }
+    ::close(fd); // The mapping keeps its own reference to the file
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (address_ != nullptr)
+    {
+        munmap(address_, size_);
+        address_ = nullptr;
+        size_ = 0;
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/**
+ * @class MappedFile
+ * @brief A read-only memory mapping of a whole file, unmapped when the object goes away.
+ *
+ * Parsers read the file straight out of the page cache through data() instead of
+ * copying it into stream buffers first.
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /**
+     * @brief Maps a file, replacing any previous mapping.
+     * @param filename The file to map.
+     * @param error Set to a description of the failure when false is returned.
+     * @return true if the file was mapped (an empty file maps to an empty view).
+     */
+    bool open(const std::string &filename, std::string &error);
+
+    /**
+     * @brief Unmaps the file.
+     */
+    void close();
+
+    std::string_view data() const { return std::string_view(static_cast<const char *>(address_), size_); }
+    size_t size() const { return size_; }
+
+private:
+    void *address_ = nullptr;
+    size_t size_ = 0;
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,145 @@
+/*
+ * OUTPUT QUEUE
+ * ------------
+ * Description: Coalesces queued responses into writev calls and survives short writes.
+ */
+#include "output_queue.h"
+#include <cerrno>
+#include <stdio.h>
+#include <sys/uio.h>
+
+#define MAXIOV 64
+
+void OutputQueue::push(std::string data)
+{
+    if (data.empty())
+    {
+        return;
+    }
+    auto owner = std::make_shared<const std::string>(std::move(data));
+    std::string_view view(*owner);
+    pending_ += view.size();
+    chunks_.push_back({std::move(owner), view, nullptr});
+}
+
+void OutputQueue::push(std::shared_ptr<const std::string> data)
+{
+    if (!data || data->empty())
+    {
+        return;
+    }
+    std::string_view view(*data);
+    pending_ += view.size();
+    chunks_.push_back({std::move(data), view, nullptr});
+}
+
+void OutputQueue::push(std::shared_ptr<const std::string> owner, std::string_view slice)
+{
+    if (slice.empty())
+    {
+        return;
+    }
+    pending_ += slice.size();
+    chunks_.push_back({std::move(owner), slice, nullptr});
+}
+
+void OutputQueue::push_static(std::string_view data)
+{
+    if (data.empty())
+    {
+        return;
+    }
+    pending_ += data.size();
+    chunks_.push_back({nullptr, data, nullptr});
+}
+
+void OutputQueue::push_producer(Producer producer)
+{
+    chunks_.push_back({nullptr, std::string_view(), std::make_unique<Producer>(std::move(producer))});
+}
+
+// Replaces producers at the front of the queue with the parts they produce
+void OutputQueue::produce_front()
+{
+    while (!chunks_.empty() && chunks_.front().producer)
+    {
+        Chunk producing = std::move(chunks_.front());
+        chunks_.pop_front();
+        OutputQueue part;
+        if ((*producing.producer)(part))
+        {
+            chunks_.push_front(std::move(producing));
+        }
+        for (auto it = part.chunks_.rbegin(); it != part.chunks_.rend(); ++it)
+        {
+            chunks_.push_front(std::move(*it));
+        }
+        pending_ += part.pending_;
+    }
+}
+
+void OutputQueue::append(OutputQueue &other)
+{
+    for (auto &chunk : other.chunks_)
+    {
+        chunks_.push_back(std::move(chunk));
+    }
+    pending_ += other.pending_;
+    other.clear();
+}
+
+void OutputQueue::clear()
+{
+    chunks_.clear();
+    pending_ = 0;
+}
+
+OutputQueue::FlushResult OutputQueue::flush(int fd)
+{
+    while (!chunks_.empty())
+    {
+        produce_front();
+        if (chunks_.empty())
+        {
+            break;
+        }
+        struct iovec iov[MAXIOV];
+        int count = 0;
+        for (auto it = chunks_.begin(); it != chunks_.end() && count < MAXIOV && !it->producer; ++it, ++count)
+        {
+            iov[count].iov_base = const_cast<char *>(it->view.data());
+            iov[count].iov_len = it->view.size();
+        }
+
+        ssize_t written = writev(fd, iov, count);
+        if (written == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                return FlushResult::WouldBlock;
+            }
+            perror("writev");
+            return FlushResult::Error;
+        }
+
+        // Drop the chunks that went out completely and trim a partially written one
+        pending_ -= written;
+        size_t remaining = written;
+        while (remaining > 0)
+        {
+            Chunk &front = chunks_.front();
+            if (remaining < front.view.size())
+            {
+                front.view.remove_prefix(remaining);
+                break;
+            }
+            remaining -= front.view.size();
+            chunks_.pop_front();
+        }
+    }
+    return FlushResult::Done;
+}
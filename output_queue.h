@@ -0,0 +1,105 @@
+#ifndef OUTPUT_QUEUE_H
+#define OUTPUT_QUEUE_H
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+/**
+ * @class OutputQueue
+ * @brief A per-connection queue of response bytes, written out with writev.
+ *
+ * Responses are queued as chunks instead of being sent one by one, so the
+ * replies to several pipelined commands leave in a single writev. flush()
+ * copes with short writes and EAGAIN by keeping whatever the socket did not
+ * take, and pending_bytes() lets the caller stop reading from a client that
+ * has stopped reading its replies.
+ *
+ * A reply too large to queue at once can be queued as a producer instead,
+ * which is asked for the next part whenever everything queued before it has
+ * been written, so such a reply never takes more than one part's memory.
+ */
+class OutputQueue
+{
+public:
+    enum class FlushResult
+    {
+        Done,       // Everything queued was written
+        WouldBlock, // The socket buffer is full; try again once it is writable
+        Error       // The connection is broken
+    };
+
+    /**
+     * @brief Queues a response the queue takes ownership of.
+     */
+    void push(std::string data);
+
+    /**
+     * @brief Queues a shared, immutable buffer without copying it.
+     */
+    void push(std::shared_ptr<const std::string> data);
+
+    /**
+     * @brief Queues part of a shared, immutable buffer without copying it.
+     * @param slice A range of *owner's bytes.
+     */
+    void push(std::shared_ptr<const std::string> owner, std::string_view slice);
+
+    /**
+     * @brief Queues bytes that outlive the queue, such as string literals.
+     */
+    void push_static(std::string_view data);
+
+    /**
+     * @brief Queues the next part of a reply into the queue it is given.
+     * @return true if there is more to come, false once the reply is complete.
+     */
+    using Producer = std::function<bool(OutputQueue &part)>;
+
+    /**
+     * @brief Queues a reply that is produced part by part as the socket takes it.
+     *
+     * The producer runs on the thread that flushes, and is dropped unrun by clear().
+     * It must queue something on every call that returns true.
+     */
+    void push_producer(Producer producer);
+
+    /**
+     * @brief Moves every chunk of another queue to the end of this one.
+     */
+    void append(OutputQueue &other);
+
+    /**
+     * @brief Writes as much as the socket accepts.
+     * @param fd The socket; on a blocking socket this only returns once everything is written.
+     */
+    FlushResult flush(int fd);
+
+    /**
+     * @brief Drops everything queued.
+     */
+    void clear();
+
+    /**
+     * @brief The bytes queued so far, not counting what producers have yet to produce.
+     */
+    size_t pending_bytes() const { return pending_; }
+    bool empty() const { return chunks_.empty(); }
+
+private:
+    struct Chunk
+    {
+        std::shared_ptr<const std::string> owner; // Keeps view alive; empty for static data
+        std::string_view view;
+        std::unique_ptr<Producer> producer; // Set on a chunk that stands for the rest of a produced reply
+    };
+
+    void produce_front();
+
+    std::deque<Chunk> chunks_;
+    size_t pending_ = 0;
+};
+
+#endif // OUTPUT_QUEUE_H
@@ -8,93 +8,94 @@
  *              This code is intended to be used as a helper function in CS447 Fall 2025 P1 server code.
  */
 #include "p1_helper.h"
-#include <fstream>
-#include <sstream>
+#include "course_parser.h"
+#include "mapped_file.h"
 #include <string>
 #include <algorithm>
+#include <thread>
+#include <unordered_set>
+
+// Files smaller than this per thread are not worth splitting
+static const size_t MIN_CHUNK_BYTES = 1 << 20;
 
 /**
- * @brief Loads course data from the specified file into memory.
+ * @brief Loads course data from the specified file into a column-oriented table.
  * @param filename The name of the database file (e.g., "courses.db").
- * @return A vector of Course structs containing all loaded courses.
+ * @param threads How many threads parse the file; 0 uses every core.
+ * @return A CourseTable holding all loaded courses.
  */
-std::vector<Course> load_courses_from_db(const std::string &filename)
+CourseTable load_course_table(const std::string &filename, unsigned threads)
 {
-    std::vector<Course> courses;
-    std::ifstream file(filename);
-    if (!file.is_open())
+    CourseTable table;
+    MappedFile file;
+    std::string error;
+    if (!file.open(filename, error))
     {
-        std::cerr << "Error: Could not open database file " << filename << std::endl;
-        return courses;
+        std::cerr << "Error: Could not open database file " << filename << ": " << error << std::endl;
+        return table;
     }
 
-    std::string line;
-    std::getline(file, line); // Skip the header line
+    // Skip the header line
+    std::string_view text = file.data();
+    size_t header_end = text.find('\n');
+    text.remove_prefix(header_end == std::string_view::npos ? text.size() : header_end + 1);
 
-    while (std::getline(file, line))
+    // Split the rows into one newline-aligned chunk per thread
+    if (threads == 0)
     {
-        std::stringstream ss(line);
-        std::string segment;
-        Course course;
-
-        // Course Code
-        std::getline(ss, segment, ';');
-        course.course_code = segment;
-
-        // Title
-        std::getline(ss, segment, ';');
-        course.title = segment;
-
-        // Subject
-        std::getline(ss, segment, ';');
-        course.subject = segment;
-
-        // Instructor
-        std::getline(ss, segment, ';');
-        course.instructor = segment;
-
-        // Prerequisites (comma-separated list)
-        std::getline(ss, segment, ';');
-        if (!segment.empty())
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    size_t chunk_count = std::max<size_t>(1, std::min<size_t>(threads, text.size() / MIN_CHUNK_BYTES));
+    std::vector<std::string_view> chunks;
+    while (chunks.size() + 1 < chunk_count)
+    {
+        size_t split = text.find('\n', text.size() / (chunk_count - chunks.size()));
+        if (split == std::string_view::npos)
         {
-            std::stringstream prereq_ss(segment);
-            std::string prereq_code;
-            while (std::getline(prereq_ss, prereq_code, ','))
-            {
-                course.prerequisites.push_back(prereq_code);
-            }
+            break;
         }
+        chunks.push_back(text.substr(0, split + 1));
+        text.remove_prefix(split + 1);
+    }
+    chunks.push_back(text);
 
-        // Seats Available
-        std::getline(ss, segment, ';');
-        try
-        {
-            course.seats_available = std::stoi(segment);
-        }
-        catch (...)
+    // Parse every chunk into its own table; line numbers are relative to the chunk until merged
+    std::vector<CourseTable> parts(chunks.size());
+    std::vector<std::vector<ParseError>> errors(chunks.size());
+    std::vector<size_t> line_counts(chunks.size());
+    {
+        std::vector<std::jthread> parsers;
+        for (size_t i = 1; i < chunks.size(); i++)
         {
-            course.seats_available = 0;
+            parsers.emplace_back([&, i]
+                                 { line_counts[i] = parse_course_rows(chunks[i], 0, parts[i], errors[i]); });
         }
+        line_counts[0] = parse_course_rows(chunks[0], 0, parts[0], errors[0]);
+    }
 
-        // Capacity
-        std::getline(ss, segment, ';');
-        try
-        {
-            course.capacity = std::stoi(segment);
-        }
-        catch (...)
+    // Merge in file order so rows keep their positions
+    size_t first_line = 2;
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        table.append(std::move(parts[i]));
+        for (const ParseError &row : errors[i])
         {
-            course.capacity = 0;
+            std::cerr << "Error: " << filename << ":" << first_line + row.line << ": skipped malformed course: " << row.message << std::endl;
         }
-
-        // Description
-        std::getline(ss, segment, ';');
-        course.description = segment;
-
-        courses.push_back(course);
+        first_line += line_counts[i];
     }
-    file.close();
-    return courses;
+    table.finish();
+    return table;
+}
+
+/**
+ * @brief Loads course data from the specified file into memory.
+ * @param filename The name of the database file (e.g., "courses.db").
+ * @return A vector of Course structs containing all loaded courses.
+ */
+std::vector<Course> load_courses_from_db(const std::string &filename)
+{
+    return to_courses(load_course_table(filename));
 }
 
 // struct Course {
@@ -214,26 +215,210 @@ bool drop_course(std::vector<Course> &courses, const std::string &course_code)
  */
 bool check_prerequisites(const std::vector<Course> &enrolled_courses, const Course &course_to_enroll)
 {
-    for(const auto &prereq : course_to_enroll.prerequisites)
+    // Hash the enrolled codes once so each prerequisite is one lookup instead of a scan
+    std::unordered_set<std::string_view> enrolled;
+    enrolled.reserve(enrolled_courses.size());
+    for (const auto &enrolled_course : enrolled_courses)
+    {
+        enrolled.insert(enrolled_course.course_code);
+    }
+    for (const auto &prereq : course_to_enroll.prerequisites)
+    {
+        if (enrolled.count(prereq) == 0)
+        {
+            return false; // A prerequisite is not met
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Builds the hash and ordered indexes for a course table.
+ * @param table The table of all courses.
+ * @return The index; rebuild it whenever the table changes.
+ */
+CourseIndex build_course_index(const CourseTable &table)
+{
+    CourseIndex index;
+
+    // Keep the table at most half full so probe sequences stay short
+    size_t buckets = 16;
+    while (buckets < table.size() * 2)
+    {
+        buckets *= 2;
+    }
+    index.code_buckets.assign(buckets, -1);
+    index.code_hashes.assign(buckets, 0);
+    for (size_t slot = 0; slot < table.size(); slot++)
     {
-        bool found = false;
-        for (const auto &enrolled_course : enrolled_courses)
+        uint64_t hash = fnv1a_hash(table.course_code(slot));
+        size_t bucket = hash & (buckets - 1);
+        while (index.code_buckets[bucket] != -1)
         {
-            if (enrolled_course.course_code == prereq)
+            if (index.code_hashes[bucket] == hash && table.course_code(index.code_buckets[bucket]) == table.course_code(slot))
             {
-                found = true;
-                break;
+                break; // Duplicate code: the first row wins, like the linear scan
             }
+            bucket = (bucket + 1) & (buckets - 1);
         }
-        if (!found)
+        if (index.code_buckets[bucket] == -1)
         {
-            return false; // A prerequisite is not met
+            index.code_buckets[bucket] = static_cast<int32_t>(slot);
+            index.code_hashes[bucket] = hash;
         }
     }
-    return true;
+
+    index.by_subject.resize(table.size());
+    for (size_t slot = 0; slot < table.size(); slot++)
+    {
+        index.by_subject[slot] = static_cast<uint32_t>(slot);
+    }
+    index.by_instructor = index.by_subject;
+    std::stable_sort(index.by_subject.begin(), index.by_subject.end(), [&](uint32_t a, uint32_t b)
+                     { return table.subject(a) < table.subject(b); });
+    std::stable_sort(index.by_instructor.begin(), index.by_instructor.end(), [&](uint32_t a, uint32_t b)
+                     { return table.instructor(a) < table.instructor(b); });
+    return index;
+}
+
+/**
+ * @brief Finds the slot of a course by its course code in O(1).
+ * @return The course's row in the table, or -1 if not found.
+ */
+int find_course_slot(const CourseTable &table, const CourseIndex &index, std::string_view course_code)
+{
+    if (index.code_buckets.empty())
+    {
+        return -1;
+    }
+    size_t mask = index.code_buckets.size() - 1;
+    uint64_t hash = fnv1a_hash(course_code);
+    for (size_t bucket = hash & mask; index.code_buckets[bucket] != -1; bucket = (bucket + 1) & mask)
+    {
+        if (index.code_hashes[bucket] == hash && table.course_code(index.code_buckets[bucket]) == course_code)
+        {
+            return index.code_buckets[bucket];
+        }
+    }
+    return -1;
 }
 
+// Collects the slots whose key contains search_term, testing each distinct key of an ordered index once
+static void collect_matching_keys(const CourseTable &table, const std::vector<uint32_t> &ordered, CourseTable::StringId (CourseTable::*key_of)(size_t) const, std::string_view search_term, std::vector<uint32_t> &results)
+{
+    size_t i = 0;
+    while (i < ordered.size())
+    {
+        CourseTable::StringId key = (table.*key_of)(ordered[i]);
+        size_t run_end = i + 1;
+        while (run_end < ordered.size() && (table.*key_of)(ordered[run_end]) == key)
+        {
+            run_end++;
+        }
+        if (table.string(key).find(search_term) != std::string_view::npos)
+        {
+            results.insert(results.end(), ordered.begin() + i, ordered.begin() + run_end);
+        }
+        i = run_end;
+    }
+    std::sort(results.begin(), results.end());
+}
 
+/**
+ * @brief Indexed equivalent of search_courses(), returning slots instead of copies.
+ * @return The slots of the matching courses, in catalog order.
+ */
+std::vector<uint32_t> search_course_slots(const CourseTable &table, const CourseIndex &index, std::string_view filter, std::string_view search_term)
+{
+    std::vector<uint32_t> results;
+    if (filter == "ALL")
+    {
+        results.resize(table.size());
+        for (size_t slot = 0; slot < table.size(); slot++)
+        {
+            results[slot] = static_cast<uint32_t>(slot);
+        }
+    }
+    else if (filter == "subject")
+    {
+        collect_matching_keys(table, index.by_subject, &CourseTable::subject_id, search_term, results);
+    }
+    else if (filter == "instructor")
+    {
+        collect_matching_keys(table, index.by_instructor, &CourseTable::instructor_id, search_term, results);
+    }
+    else if (filter == "course-code")
+    {
+        for (size_t slot = 0; slot < table.size(); slot++)
+        {
+            if (table.course_code(slot).find(search_term) != std::string_view::npos)
+            {
+                results.push_back(static_cast<uint32_t>(slot));
+            }
+        }
+    }
+    return results;
+}
+
+/**
+ * @brief Copies one row of a course table into a Course struct.
+ */
+Course to_course(const CourseTable &table, size_t row)
+{
+    Course course;
+    course.course_code = table.course_code(row);
+    course.title = table.title(row);
+    course.subject = table.subject(row);
+    course.instructor = table.instructor(row);
+    for (size_t i = 0; i < table.prerequisite_count(row); i++)
+    {
+        course.prerequisites.emplace_back(table.prerequisite(row, i));
+    }
+    course.seats_available = table.seats_available(row);
+    course.capacity = table.capacity(row);
+    course.description = table.description(row);
+    return course;
+}
 
+/**
+ * @brief Copies every row of a course table into a vector of Course structs.
+ */
+std::vector<Course> to_courses(const CourseTable &table)
+{
+    std::vector<Course> courses;
+    courses.reserve(table.size());
+    for (size_t row = 0; row < table.size(); row++)
+    {
+        courses.push_back(to_course(table, row));
+    }
+    return courses;
+}
 
+/**
+ * @brief Packs a vector of Course structs into a course table.
+ */
+CourseTable to_course_table(const std::vector<Course> &courses)
+{
+    CourseTable table;
+    std::vector<std::string_view> prerequisites;
+    for (const Course &course : courses)
+    {
+        prerequisites.assign(course.prerequisites.begin(), course.prerequisites.end());
+        table.add(course.course_code, course.title, course.subject, course.instructor, prerequisites, course.seats_available, course.capacity, course.description);
+    }
+    table.finish();
+    return table;
+}
 
+/**
+ * @brief Searches a course table, returning copies like the vector version.
+ */
+std::vector<Course> search_courses(const CourseTable &table, const CourseIndex &index, const std::string &filter, const std::string &search_term)
+{
+    std::vector<Course> results;
+    for (uint32_t slot : search_course_slots(table, index, filter, search_term))
+    {
+        results.push_back(to_course(table, slot));
+    }
+    return results;
+}
@@ -1,9 +1,12 @@
 #ifndef P1_HELPER_H
 #define P1_HELPER_H
 
+#include <cstdint>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
+#include "course_table.h"
 
 /**
  * @struct Course
@@ -71,4 +74,87 @@ bool drop_course(std::vector<Course>& courses, const std::string& course_code);
  */
 bool check_prerequisites(const std::vector<Course>& enrolled_courses, const Course& course_to_enroll);
 
+/**
+ * @brief Loads course data from the specified file into a column-oriented table.
+ * @param filename The name of the database file (e.g., "courses.db").
+ * @param threads How many threads parse the file; 0 uses every core.
+ * @return A CourseTable holding all loaded courses.
+ *
+ * The file is memory-mapped and parsed in place. Large files are split into
+ * newline-aligned chunks that are parsed in parallel and merged in file order. Blank lines are skipped, and
+ * malformed rows are left out and reported on stderr with their line numbers.
+ * load_courses_from_db() is an adapter over this that copies the rows out into Course structs.
+ */
+CourseTable load_course_table(const std::string& filename, unsigned threads = 0);
+
+/**
+ * @brief Copies one row of a course table into a Course struct.
+ */
+Course to_course(const CourseTable& table, size_t row);
+
+/**
+ * @brief Copies every row of a course table into a vector of Course structs.
+ */
+std::vector<Course> to_courses(const CourseTable& table);
+
+/**
+ * @brief Packs a vector of Course structs into a course table.
+ */
+CourseTable to_course_table(const std::vector<Course>& courses);
+
+/**
+ * @struct CourseIndex
+ * @brief Lookup structures over a course table, built once at load time.
+ *
+ * Slots are rows of the table the index was built from, so they stay valid for
+ * as long as that table is not modified.
+ */
+struct CourseIndex {
+    // Open-addressing hash table (linear probing) from course code to slot, -1 marks an empty bucket
+    std::vector<int32_t> code_buckets;
+    std::vector<uint64_t> code_hashes; // The full hash of each bucket's code, checked before comparing strings
+    // Secondary indexes: every slot, ordered by subject (or instructor) and then by slot
+    std::vector<uint32_t> by_subject;
+    std::vector<uint32_t> by_instructor;
+};
+
+/**
+ * @brief Builds the hash and ordered indexes for a course table.
+ * @param table The table of all courses.
+ * @return The index; rebuild it whenever the table changes.
+ */
+CourseIndex build_course_index(const CourseTable& table);
+
+/**
+ * @brief Finds the slot of a course by its course code in O(1).
+ * @param table The table the index was built from.
+ * @param index The index built by build_course_index().
+ * @param course_code The unique identifier for the course.
+ * @return The course's row in the table, or -1 if not found.
+ */
+int find_course_slot(const CourseTable& table, const CourseIndex& index, std::string_view course_code);
+
+/**
+ * @brief Indexed equivalent of search_courses(), returning slots instead of copies.
+ * @param table The table the index was built from.
+ * @param index The index built by build_course_index().
+ * @param filter The category to search by (e.g., "subject", "instructor", "course-code", "ALL").
+ * @param search_term The term to search for.
+ * @return The slots of the matching courses, in catalog order.
+ *
+ * Subject and instructor filters test every distinct value once through the ordered
+ * index instead of testing every course.
+ */
+std::vector<uint32_t> search_course_slots(const CourseTable& table, const CourseIndex& index, std::string_view filter, std::string_view search_term);
+
+/**
+ * @brief Searches a course table, returning copies like the vector version.
+ * @param table The table the index was built from.
+ * @param index The index built by build_course_index(); it is not rebuilt per search.
+ * @param filter The category to search by (e.g., "subject", "instructor", "course-code").
+ * @param search_term The term to search for.
+ * @return A vector of matching Course structs.
+ */
+std::vector<Course> search_courses(const CourseTable& table, const CourseIndex& index, const std::string& filter, const std::string& search_term);
+
 #endif // P1_HELPER_H
@@ -0,0 +1,180 @@
+/*
+ * PACKED COLUMN
+ * -------------
+ * Description: Contiguous copies of the searchable course fields and the vectorized
+ *              substring matchers that scan them.
+ */
+#include "packed_column.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#endif
+
+void PackedColumn::add(std::string_view value)
+{
+    if (offsets_.empty())
+    {
+        offsets_.push_back(0);
+    }
+    data_.append(value);
+    data_.push_back('\0');
+    offsets_.push_back(static_cast<uint32_t>(data_.size()));
+}
+
+void PackedColumn::clear()
+{
+    data_.clear();
+    offsets_.clear();
+}
+
+// Returns the first occurrence of needle (at least one byte) in [p, end), or nullptr
+static const char *scan_scalar(const char *p, const char *end, std::string_view needle)
+{
+    const size_t n = needle.size();
+    const char first = needle[0];
+    for (; end - p >= static_cast<ptrdiff_t>(n); p++)
+    {
+        if (*p == first && std::memcmp(p + 1, needle.data() + 1, n - 1) == 0)
+        {
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+#ifdef HAVE_X86_SIMD
+
+// Compares 16 bytes at a time with PCMPESTRI, which also reports a needle that starts
+// near the end of a block, so only candidate positions are verified with memcmp
+__attribute__((target("sse4.2"))) static const char *scan_sse42(const char *p, const char *end, std::string_view needle)
+{
+    const size_t n = needle.size();
+    const int head = static_cast<int>(std::min<size_t>(n, 16));
+    char pattern_bytes[16] = {};
+    std::memcpy(pattern_bytes, needle.data(), head);
+    const __m128i pattern = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pattern_bytes));
+
+    while (end - p >= 16)
+    {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        int index = _mm_cmpestri(pattern, head, block, 16, _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ORDERED);
+        if (index == 16)
+        {
+            p += 16;
+            continue;
+        }
+        const char *candidate = p + index;
+        if (end - candidate < static_cast<ptrdiff_t>(n))
+        {
+            return nullptr; // Too close to the end for a full match here or anywhere later
+        }
+        if (std::memcmp(candidate, needle.data(), n) == 0)
+        {
+            return candidate;
+        }
+        p = candidate + 1;
+    }
+    return scan_scalar(p, end, needle);
+}
+
+// Tests 32 positions at a time against the needle's first and last byte and only
+// verifies the positions where both match
+__attribute__((target("avx2"))) static const char *scan_avx2(const char *p, const char *end, std::string_view needle)
+{
+    const size_t n = needle.size();
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[n - 1]);
+
+    while (end - p >= static_cast<ptrdiff_t>(n + 31))
+    {
+        __m256i block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        __m256i block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + n - 1));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(first, block_first), _mm256_cmpeq_epi8(last, block_last))));
+        while (mask != 0)
+        {
+            int bit = __builtin_ctz(mask);
+            if (n <= 2 || std::memcmp(p + bit + 1, needle.data() + 1, n - 2) == 0)
+            {
+                return p + bit;
+            }
+            mask &= mask - 1;
+        }
+        p += 32;
+    }
+    return scan_scalar(p, end, needle);
+}
+
+#endif // HAVE_X86_SIMD
+
+bool PackedColumn::supported(Matcher matcher)
+{
+    switch (matcher)
+    {
+    case Matcher::Best:
+    case Matcher::Scalar:
+        return true;
+#ifdef HAVE_X86_SIMD
+    case Matcher::SSE42:
+        return __builtin_cpu_supports("sse4.2");
+    case Matcher::AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+std::vector<uint32_t> PackedColumn::find(std::string_view needle, Matcher matcher) const
+{
+    std::vector<uint32_t> rows_found;
+    if (needle.empty())
+    {
+        rows_found.resize(rows());
+        for (size_t row = 0; row < rows_found.size(); row++)
+        {
+            rows_found[row] = static_cast<uint32_t>(row);
+        }
+        return rows_found;
+    }
+    if (rows() == 0 || needle.find('\0') != std::string_view::npos)
+    {
+        return rows_found;
+    }
+
+    // Resolve the matcher once per call rather than once per candidate
+    static const Matcher best = supported(Matcher::AVX2) ? Matcher::AVX2 : supported(Matcher::SSE42) ? Matcher::SSE42
+                                                                                                      : Matcher::Scalar;
+    if (matcher == Matcher::Best || !supported(matcher))
+    {
+        matcher = best;
+    }
+    const char *(*scan)(const char *, const char *, std::string_view) = scan_scalar;
+#ifdef HAVE_X86_SIMD
+    if (matcher == Matcher::AVX2)
+    {
+        scan = scan_avx2;
+    }
+    else if (matcher == Matcher::SSE42)
+    {
+        scan = scan_sse42;
+    }
+#endif
+
+    const char *base = data_.data();
+    const char *end = base + data_.size();
+    const char *p = base;
+    auto row_start = offsets_.begin();
+    while (const char *match = scan(p, end, needle))
+    {
+        // The row holding the match, then carry on from the start of the next row
+        row_start = std::upper_bound(row_start, offsets_.end(), static_cast<uint32_t>(match - base)) - 1;
+        size_t row = row_start - offsets_.begin();
+        rows_found.push_back(static_cast<uint32_t>(row));
+        p = base + offsets_[row + 1];
+    }
+    return rows_found;
+}
@@ -0,0 +1,60 @@
+#ifndef PACKED_COLUMN_H
+#define PACKED_COLUMN_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class PackedColumn
+ * @brief One text field of every course, packed back to back into a single buffer.
+ *
+ * Substring filters that no index can serve scan this buffer in one pass with a
+ * vectorized matcher (AVX2 or SSE4.2, picked at runtime, with a scalar fallback)
+ * and return the matching row ids without touching or copying any Course.
+ * Values are separated by '\0', so a match can never span two rows.
+ */
+class PackedColumn
+{
+public:
+    enum class Matcher
+    {
+        Best,   // The fastest one this CPU supports
+        Scalar,
+        SSE42,
+        AVX2
+    };
+
+    /**
+     * @brief Appends the value of the next row.
+     */
+    void add(std::string_view value);
+
+    /**
+     * @brief Removes every row.
+     */
+    void clear();
+
+    /**
+     * @brief Finds every row whose value contains needle (case-sensitive, like std::string::find).
+     * @param needle The substring to look for; an empty needle matches every row.
+     * @param matcher Which implementation to use; only benchmarks need to pick one.
+     * @return The matching row ids in ascending order.
+     */
+    std::vector<uint32_t> find(std::string_view needle, Matcher matcher = Matcher::Best) const;
+
+    /**
+     * @brief Whether this CPU can run a matcher.
+     */
+    static bool supported(Matcher matcher);
+
+    size_t rows() const { return offsets_.empty() ? 0 : offsets_.size() - 1; }
+    std::string_view value(size_t row) const { return std::string_view(data_.data() + offsets_[row], offsets_[row + 1] - offsets_[row] - 1); }
+
+private:
+    std::string data_;              // Values, each followed by '\0'; the matchers handle the tail without reading past the end
+    std::vector<uint32_t> offsets_; // Row i starts at offsets_[i]; the last entry is the end of the data
+};
+
+#endif // PACKED_COLUMN_H
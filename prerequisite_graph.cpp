@@ -0,0 +1,273 @@
+/*
+ * PREREQUISITE GRAPH
+ * ------------------
+ * Description: The catalog's prerequisites as an integer DAG, so eligibility is a bitset AND
+ *              instead of comparing course code strings.
+ */
+#include "prerequisite_graph.h"
+#include <algorithm>
+#include <unordered_set>
+
+void CourseSet::insert(uint32_t slot)
+{
+    uint32_t word = slot / 64;
+    auto position = std::lower_bound(words_.begin(), words_.end(), word);
+    size_t i = position - words_.begin();
+    if (position == words_.end() || *position != word)
+    {
+        words_.insert(position, word);
+        bits_.insert(bits_.begin() + i, 0);
+    }
+    bits_[i] |= uint64_t(1) << (slot % 64);
+}
+
+bool CourseSet::contains_all(uint32_t word, uint64_t mask) const
+{
+    auto position = std::lower_bound(words_.begin(), words_.end(), word);
+    return position != words_.end() && *position == word && (bits_[position - words_.begin()] & mask) == mask;
+}
+
+void PrerequisiteGraph::build(const CourseTable &table, const CourseIndex &index, std::vector<std::string> &problems)
+{
+    edge_offsets_.assign(1, 0);
+    edges_.clear();
+    requirement_offsets_.assign(1, 0);
+    requirement_words_.clear();
+    requirement_masks_.clear();
+    edge_offsets_.reserve(table.size() + 1);
+    requirement_offsets_.reserve(table.size() + 1);
+
+    std::vector<uint32_t> prerequisites;
+    std::vector<bool> missing(table.size());
+    for (size_t row = 0; row < table.size(); row++)
+    {
+        prerequisites.clear();
+        for (size_t i = 0; i < table.prerequisite_count(row); i++)
+        {
+            int slot = find_course_slot(table, index, table.prerequisite(row, i));
+            if (slot == -1)
+            {
+                missing[row] = true;
+                problems.push_back(std::string(table.course_code(row)) + " lists unknown prerequisite " + std::string(table.prerequisite(row, i)));
+                continue;
+            }
+            prerequisites.push_back(slot);
+        }
+        std::sort(prerequisites.begin(), prerequisites.end());
+        prerequisites.erase(std::unique(prerequisites.begin(), prerequisites.end()), prerequisites.end());
+        edges_.insert(edges_.end(), prerequisites.begin(), prerequisites.end());
+        edge_offsets_.push_back(edges_.size());
+
+        // Sorted slots fall into runs that share a word; each run becomes one (word, mask) pair
+        for (uint32_t slot : prerequisites)
+        {
+            uint32_t word = slot / 64;
+            if (requirement_words_.size() == requirement_offsets_.back() || requirement_words_.back() != word)
+            {
+                requirement_words_.push_back(word);
+                requirement_masks_.push_back(0);
+            }
+            requirement_masks_.back() |= uint64_t(1) << (slot % 64);
+        }
+        if (missing[row])
+        {
+            requirement_words_.push_back(MISSING_WORD);
+            requirement_masks_.push_back(1);
+        }
+        requirement_offsets_.push_back(requirement_words_.size());
+    }
+    build_chains(table, missing, problems);
+}
+
+void PrerequisiteGraph::build_chains(const CourseTable &table, const std::vector<bool> &missing, std::vector<std::string> &problems)
+{
+    const uint32_t UNVISITED = UINT32_MAX;
+    size_t count = size();
+    component_of_.assign(count, UNVISITED);
+    member_offsets_.assign(1, 0);
+    members_.clear();
+    exit_offsets_.assign(1, 0);
+    exits_.clear();
+    members_.reserve(count);
+    flags_.assign(count, 0);
+
+    // Tarjan's strongly connected components, iteratively so that long chains cannot overflow the stack
+    std::vector<uint32_t> order(count, UNVISITED), low(count);
+    std::vector<bool> on_stack(count);
+    std::vector<uint32_t> stack, component;
+    std::vector<uint32_t> seen(count, UNVISITED); // The component that last listed a slot among its exits
+    struct Frame
+    {
+        uint32_t slot;
+        uint32_t next; // Next prerequisite edge to follow
+    };
+    std::vector<Frame> frames;
+    uint32_t visited = 0, components = 0;
+
+    auto visit = [&](uint32_t slot)
+    {
+        order[slot] = low[slot] = visited++;
+        stack.push_back(slot);
+        on_stack[slot] = true;
+        frames.push_back({slot, 0});
+    };
+
+    for (uint32_t root = 0; root < count; root++)
+    {
+        if (order[root] != UNVISITED)
+        {
+            continue;
+        }
+        visit(root);
+        while (!frames.empty())
+        {
+            uint32_t slot = frames.back().slot;
+            if (frames.back().next < prerequisite_count(slot))
+            {
+                uint32_t prerequisite_slot = prerequisite(slot, frames.back().next++);
+                if (order[prerequisite_slot] == UNVISITED)
+                {
+                    visit(prerequisite_slot);
+                }
+                else if (on_stack[prerequisite_slot])
+                {
+                    low[slot] = std::min(low[slot], order[prerequisite_slot]);
+                }
+                continue;
+            }
+            frames.pop_back();
+            if (!frames.empty())
+            {
+                low[frames.back().slot] = std::min(low[frames.back().slot], low[slot]);
+            }
+            if (low[slot] != order[slot])
+            {
+                continue;
+            }
+
+            // slot roots a finished component; every component it depends on is already numbered
+            component.clear();
+            uint32_t member;
+            do
+            {
+                member = stack.back();
+                stack.pop_back();
+                on_stack[member] = false;
+                component.push_back(member);
+            } while (member != slot);
+            uint32_t number = components++;
+            for (uint32_t course : component)
+            {
+                component_of_[course] = number;
+            }
+
+            bool cyclic = component.size() > 1;
+            uint8_t flags = 0;
+            for (uint32_t course : component)
+            {
+                flags |= missing[course] ? INCOMPLETE : 0;
+                for (size_t i = 0; i < prerequisite_count(course); i++)
+                {
+                    uint32_t before = prerequisite(course, i);
+                    if (before == course)
+                    {
+                        cyclic = true;
+                    }
+                    if (component_of_[before] == number || seen[before] == number)
+                    {
+                        continue;
+                    }
+                    seen[before] = number;
+                    exits_.push_back(before);
+                    flags |= flags_[before] & (CYCLE | INCOMPLETE);
+                }
+            }
+            exit_offsets_.push_back(exits_.size());
+            std::sort(component.begin(), component.end());
+            members_.insert(members_.end(), component.begin(), component.end());
+            member_offsets_.push_back(members_.size());
+            if (cyclic)
+            {
+                flags |= CYCLE | ON_CYCLE;
+                std::string names;
+                for (uint32_t course : component)
+                {
+                    names += (names.empty() ? "" : ", ") + std::string(table.course_code(course));
+                }
+                problems.push_back("prerequisite cycle among " + names);
+            }
+            for (uint32_t course : component)
+            {
+                flags_[course] = flags;
+            }
+        }
+    }
+}
+
+std::vector<uint32_t> PrerequisiteGraph::chain(uint32_t slot) const
+{
+    // Depth first over the condensation: a component's exits, each after its own chain, then its
+    // members. The course's own component only lists its members when it is a cycle.
+    std::vector<uint32_t> chain;
+    std::unordered_set<uint32_t> seen;
+    struct Frame
+    {
+        uint32_t component;
+        uint32_t next; // Next exit to follow
+    };
+    uint32_t start = component_of_[slot];
+    std::vector<Frame> frames = {{start, exit_offsets_[start]}};
+    while (!frames.empty())
+    {
+        Frame &frame = frames.back();
+        if (frame.next < exit_offsets_[frame.component + 1])
+        {
+            uint32_t before = exits_[frame.next++];
+            if (!seen.count(before))
+            {
+                uint32_t component = component_of_[before];
+                frames.push_back({component, exit_offsets_[component]});
+            }
+            continue;
+        }
+        uint32_t component = frame.component;
+        frames.pop_back();
+        if (component == start && !(flags_[slot] & ON_CYCLE))
+        {
+            continue;
+        }
+        for (uint32_t i = member_offsets_[component]; i < member_offsets_[component + 1]; i++)
+        {
+            if (seen.insert(members_[i]).second)
+            {
+                chain.push_back(members_[i]);
+            }
+        }
+    }
+    return chain;
+}
+
+bool PrerequisiteGraph::eligible(uint32_t slot, const CourseSet &taken) const
+{
+    for (uint32_t pair = requirement_offsets_[slot]; pair < requirement_offsets_[slot + 1]; pair++)
+    {
+        if (!taken.contains_all(requirement_words_[pair], requirement_masks_[pair]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<uint32_t> PrerequisiteGraph::eligible_courses(const CourseSet &taken) const
+{
+    std::vector<uint32_t> slots;
+    for (uint32_t slot = 0; slot < size(); slot++)
+    {
+        if (eligible(slot, taken) && !taken.contains(slot))
+        {
+            slots.push_back(slot);
+        }
+    }
+    return slots;
+}
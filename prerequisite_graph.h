@@ -0,0 +1,126 @@
+#ifndef PREREQUISITE_GRAPH_H
+#define PREREQUISITE_GRAPH_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "p1_helper.h"
+
+/**
+ * @class CourseSet
+ * @brief A set of catalog slots as a sparse bitset: only the 64-bit words that have a bit set, in word order.
+ *
+ * A student's courses touch a handful of words however large the catalog is,
+ * so the set stays a few dozen bytes instead of one bit per course.
+ */
+class CourseSet
+{
+public:
+    void insert(uint32_t slot);
+    bool contains(uint32_t slot) const { return contains_all(slot / 64, uint64_t(1) << (slot % 64)); }
+
+    /**
+     * @brief Whether every bit of mask is set in the given word of the bitset.
+     */
+    bool contains_all(uint32_t word, uint64_t mask) const;
+
+    bool empty() const { return words_.empty(); }
+
+private:
+    std::vector<uint32_t> words_; // Sorted word numbers
+    std::vector<uint64_t> bits_;  // bits_[i] is word words_[i]
+};
+
+/**
+ * @class PrerequisiteGraph
+ * @brief The prerequisite DAG of one catalog, with courses as integer slots, built at load time.
+ *
+ * Each course's prerequisites are kept twice, in CSR form: as edges to the
+ * prerequisite slots, and as a requirement, the (word, mask) pairs of a bitset
+ * with one bit per prerequisite. A student is eligible for a course when each
+ * pair is contained in their CourseSet, i.e. the bitset AND gives the mask back.
+ * Checking the whole catalog is one pass over these pairs, with no strings
+ * compared. A prerequisite that is not in the catalog can never be met.
+ *
+ * The build also condenses the graph for prerequisite chains. Strongly
+ * connected components are found with Tarjan's algorithm, which finishes a
+ * component only after everything it depends on, so numbering them as they
+ * finish puts the condensation DAG in topological order. Each component keeps
+ * its members and the prerequisites that lead out of it, so the storage is
+ * linear in the courses and edges. A chain is walked from these on request,
+ * in time proportional to the chain and the edges inside it, rather than kept
+ * expanded: one copy per course would grow with the square of a long chain.
+ */
+class PrerequisiteGraph
+{
+public:
+    /**
+     * @brief Builds the graph for a course table, replacing any previous contents.
+     * @param table The table of all courses.
+     * @param index The index built from the same table, used to resolve prerequisite codes to slots.
+     * @param problems Receives a description of every unknown prerequisite code and every prerequisite cycle.
+     */
+    void build(const CourseTable &table, const CourseIndex &index, std::vector<std::string> &problems);
+
+    /**
+     * @brief Whether every prerequisite of a course is in the set.
+     */
+    bool eligible(uint32_t slot, const CourseSet &taken) const;
+
+    /**
+     * @brief Every course whose prerequisites are all in the set and that is not in the set itself.
+     * @return The slots, in catalog order.
+     */
+    std::vector<uint32_t> eligible_courses(const CourseSet &taken) const;
+
+    size_t size() const { return requirement_offsets_.size() - 1; }
+
+    /**
+     * @brief The prerequisites of a course as slots; those missing from the catalog are left out.
+     */
+    size_t prerequisite_count(uint32_t slot) const { return edge_offsets_[slot + 1] - edge_offsets_[slot]; }
+    uint32_t prerequisite(uint32_t slot, size_t i) const { return edges_[edge_offsets_[slot] + i]; }
+
+    /**
+     * @brief Every course that must be taken before a course, directly or not, in an order that could be taken.
+     *
+     * A course on a cycle has every course of the cycle, itself included, in its chain.
+     */
+    std::vector<uint32_t> chain(uint32_t slot) const;
+
+    /**
+     * @brief Whether a course lies on, or depends on, a prerequisite cycle, which makes it impossible to enroll in.
+     */
+    bool blocked_by_cycle(uint32_t slot) const { return flags_[slot] & CYCLE; }
+
+    /**
+     * @brief Whether a course's chain is missing courses because some prerequisite, directly or not, is not in the catalog.
+     */
+    bool incomplete(uint32_t slot) const { return flags_[slot] & INCOMPLETE; }
+
+private:
+    static constexpr uint32_t MISSING_WORD = UINT32_MAX; // The word of a requirement no set can meet
+    enum Flag : uint8_t
+    {
+        CYCLE = 1,
+        INCOMPLETE = 2,
+        ON_CYCLE = 4 // The course's own component is a cycle, not just one it depends on
+    };
+
+    void build_chains(const CourseTable &table, const std::vector<bool> &missing, std::vector<std::string> &problems);
+
+    std::vector<uint32_t> edge_offsets_ = {0};        // Prerequisites of slot s are edges_[edge_offsets_[s] .. edge_offsets_[s + 1])
+    std::vector<uint32_t> edges_;
+    std::vector<uint32_t> requirement_offsets_ = {0}; // Requirement of slot s is the pairs [requirement_offsets_[s] .. requirement_offsets_[s + 1])
+    std::vector<uint32_t> requirement_words_;
+    std::vector<uint64_t> requirement_masks_;
+    std::vector<uint32_t> component_of_;              // Component of each slot; components are numbered prerequisites first
+    std::vector<uint32_t> member_offsets_ = {0};      // Members of component c are members_[member_offsets_[c] .. member_offsets_[c + 1]), sorted
+    std::vector<uint32_t> members_;
+    std::vector<uint32_t> exit_offsets_ = {0};        // Prerequisites outside component c are exits_[exit_offsets_[c] .. exit_offsets_[c + 1])
+    std::vector<uint32_t> exits_;
+    std::vector<uint8_t> flags_;                      // Flag bits per slot
+};
+
+#endif // PREREQUISITE_GRAPH_H
@@ -0,0 +1,111 @@
+/*
+ * REGISTRAR
+ * ---------
+ * Description: ENROLL and DROP against the shared student store, backed by the enrollment log.
+ */
+#include "registrar.h"
+#include <functional>
+#include <iostream>
+
+bool Registrar::open_log(const std::string &path, std::chrono::microseconds commit_window, std::chrono::seconds checkpoint_interval, std::string &error)
+{
+    size_t replayed = 0, missing = 0, overbooked = 0;
+    Catalog::View catalog = catalog_.view();
+    bool opened = log_.open(path, commit_window, checkpoint_interval, [&](EnrollmentLog::Op op, std::string_view student, std::string_view course_code)
+                            {
+                                std::string name(student), code(course_code);
+                                int slot = catalog.find(code);
+                                // Retake or return the seat only when the enrollment changes; one whose course has
+                                // since left the catalog, or no longer has a seat for it, is kept without one
+                                if (op == EnrollmentLog::Op::Enroll && students_.enroll(name, code))
+                                {
+                                    if (slot == -1)
+                                    {
+                                        missing++;
+                                    }
+                                    else if (!catalog.seats(slot).take())
+                                    {
+                                        overbooked++;
+                                        seatless_.emplace(name, code);
+                                    }
+                                }
+                                else if (op == EnrollmentLog::Op::Drop && students_.drop(name, code) && slot != -1 && seatless_.erase({name, code}) == 0)
+                                {
+                                    catalog.seats(slot).give_back();
+                                }
+                                replayed++; },
+                            error);
+    any_seatless_.store(!seatless_.empty(), std::memory_order_release);
+    if (opened && replayed > 0)
+    {
+        std::cout << "server: replayed " << replayed << " enrollment record(s) from " << path << std::endl;
+    }
+    if (opened && missing > 0)
+    {
+        std::cerr << "server: " << missing << " replayed enrollment(s) name a course no longer in the catalog" << std::endl;
+    }
+    if (opened && overbooked > 0)
+    {
+        std::cerr << "server: " << overbooked << " replayed enrollment(s) found their course full and hold no seat" << std::endl;
+    }
+    return opened;
+}
+
+Registrar::Result Registrar::enroll(const std::string &student, const std::string &course_code, SeatCounter &seats)
+{
+    // Held until the record is logged, so a DROP from the student's other connection cannot be
+    // logged ahead of this ENROLL, or return the seat this call may still have to give back
+    std::lock_guard guard(student_lock(student));
+    if (!students_.enroll(student, course_code))
+    {
+        return Result::AlreadyEnrolled;
+    }
+    if (!seats.take())
+    {
+        students_.drop(student, course_code);
+        return Result::CourseFull;
+    }
+    // The enrollment is only acknowledged once it is in the log
+    if (log_.is_open() && !log_.append(EnrollmentLog::Op::Enroll, student, course_code))
+    {
+        seats.give_back();
+        students_.drop(student, course_code);
+        return Result::LogFailed;
+    }
+    return Result::Ok;
+}
+
+Registrar::Result Registrar::drop(const std::string &student, const std::string &course_code)
+{
+    std::lock_guard guard(student_lock(student));
+    size_t position = 0;
+    if (!students_.drop(student, course_code, &position))
+    {
+        return Result::NotEnrolled;
+    }
+    if (log_.is_open() && !log_.append(EnrollmentLog::Op::Drop, student, course_code))
+    {
+        students_.restore(student, course_code, position);
+        return Result::LogFailed;
+    }
+    if (!release_seatless(student, course_code))
+    {
+        catalog_.drop_course(course_code);
+    }
+    return Result::Ok;
+}
+
+bool Registrar::release_seatless(const std::string &student, const std::string &course_code)
+{
+    if (!any_seatless_.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+    std::lock_guard guard(seatless_lock_);
+    return seatless_.erase({student, course_code}) > 0;
+}
+
+std::mutex &Registrar::student_lock(const std::string &student)
+{
+    return student_locks_[std::hash<std::string>()(student) % students_.shard_count()].lock;
+}
@@ -0,0 +1,104 @@
+#ifndef REGISTRAR_H
+#define REGISTRAR_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include "catalog.h"
+#include "enrollment_log.h"
+#include "student_store.h"
+
+/**
+ * @class Registrar
+ * @brief Remembers which courses each student is enrolled in, across connections and restarts.
+ *
+ * Every ENROLL and DROP goes through here. Enrollments live in a StudentStore
+ * keyed by the name given with IAM, so every connection of a student sees the
+ * same courses. One student's changes are made one at a time, from the store
+ * update through the log append, so their records reach the log in the order
+ * the store saw them. With a log open, a change is durable before enroll() or
+ * drop() returns, and opening the log replays it: every student's enrollments
+ * are rebuilt and the seats taken are taken again in the catalog. A replayed
+ * enrollment whose course is full by then is kept without a seat and reported,
+ * and dropping it later gives no seat back.
+ */
+class Registrar
+{
+public:
+    enum class Result
+    {
+        Ok,
+        AlreadyEnrolled,
+        NotEnrolled,
+        CourseFull,
+        LogFailed // The change could not be made durable and was undone
+    };
+
+    /**
+     * @param student_shards The number of StudentStore shards; 0 picks the default.
+     */
+    explicit Registrar(Catalog &catalog, size_t student_shards = 0)
+        : catalog_(catalog), students_(student_shards), student_locks_(std::make_unique<StudentLock[]>(students_.shard_count())) {}
+
+    /**
+     * @brief Replays the enrollment log into the student store and the catalog's seats, then keeps appending to it.
+     * @param path The log's base path, see EnrollmentLog::open(); it is created if missing.
+     * @param commit_window How long to collect records before syncing them as one batch.
+     * @param checkpoint_interval How often to fold the log into a checkpoint; zero never does.
+     * @param error Set to a description of the failure when false is returned.
+     * @return true if the log is open.
+     */
+    bool open_log(const std::string &path, std::chrono::microseconds commit_window, std::chrono::seconds checkpoint_interval, std::string &error);
+
+    /**
+     * @brief Enrolls a student: reserves the course in their enrollments, takes a seat, then logs it.
+     * @param seats The course's seat counter, from the catalog view the caller looked the course up in.
+     */
+    Result enroll(const std::string &student, const std::string &course_code, SeatCounter &seats);
+
+    /**
+     * @brief Drops a course: removes it from the student's enrollments, logs it, then gives the seat back.
+     */
+    Result drop(const std::string &student, const std::string &course_code);
+
+    /**
+     * @brief Every student's enrollments and mode preference.
+     */
+    StudentStore &students() { return students_; }
+    const StudentStore &students() const { return students_; }
+
+    /**
+     * @brief The enrollment log, for reports on how records are batched.
+     */
+    const EnrollmentLog &log() const { return log_; }
+
+private:
+    /**
+     * @brief Forgets an enrollment replayed without a seat.
+     * @return true if it was one, so there is no seat to give back.
+     */
+    bool release_seatless(const std::string &student, const std::string &course_code);
+
+    /**
+     * @brief The lock that orders a student's enrollment changes, shared with the students that hash alike.
+     */
+    std::mutex &student_lock(const std::string &student);
+
+    Catalog &catalog_;
+    StudentStore students_;
+    EnrollmentLog log_;
+    std::mutex seatless_lock_;
+    std::set<std::pair<std::string, std::string>> seatless_; // (student, course) enrollments replayed into a full course
+    std::atomic<bool> any_seatless_{false};                  // Lets drop() skip the lock when there are none
+    struct alignas(64) StudentLock
+    {
+        std::mutex lock;
+    };
+    std::unique_ptr<StudentLock[]> student_locks_; // One per StudentStore shard, held across a change's log append
+};
+
+#endif // REGISTRAR_H
@@ -0,0 +1,64 @@
+#ifndef REQUEST_ARENA_H
+#define REQUEST_ARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+
+/**
+ * @class RequestArena
+ * @brief Bump-allocated memory for the temporaries of one command, released in bulk when it is done.
+ *
+ * A command's cache key, copy of the student's enrollments and the like are
+ * carved out of a small buffer inside the arena and never freed one by one;
+ * reset() rewinds the arena for the next command. Whatever does not fit comes
+ * from a pool private to the connection, so a busy client recycles its own
+ * blocks instead of going to the process-wide allocator, and all of them are
+ * handed back at once when the connection closes.
+ *
+ * An arena belongs to one connection, whose commands run one at a time, so it
+ * is not thread-safe.
+ */
+class RequestArena
+{
+public:
+    RequestArena() : request_(buffer_, INLINE_BYTES, &connection_) {}
+
+    RequestArena(const RequestArena &) = delete;
+    RequestArena &operator=(const RequestArena &) = delete;
+
+    /**
+     * @brief The memory resource to give the command's pmr containers.
+     */
+    std::pmr::memory_resource *resource() { return &request_; }
+
+    /**
+     * @brief Frees everything allocated since the last reset. Nothing allocated from the arena may be used afterwards.
+     */
+    void reset() { request_.release(); }
+
+private:
+    static constexpr size_t INLINE_BYTES = 2048;
+
+    alignas(std::max_align_t) std::byte buffer_[INLINE_BYTES];
+    std::pmr::unsynchronized_pool_resource connection_; // Declared before request_, which draws on it
+    std::pmr::monotonic_buffer_resource request_;
+};
+
+/**
+ * @class RequestScope
+ * @brief Resets an arena when the command that uses it returns, whichever way it returns.
+ */
+class RequestScope
+{
+public:
+    explicit RequestScope(RequestArena &arena) : arena_(arena) {}
+    ~RequestScope() { arena_.reset(); }
+
+    RequestScope(const RequestScope &) = delete;
+    RequestScope &operator=(const RequestScope &) = delete;
+
+private:
+    RequestArena &arena_;
+};
+
+#endif // REQUEST_ARENA_H
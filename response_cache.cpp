@@ -0,0 +1,177 @@
+/*
+ * RESPONSE CACHE
+ * --------------
+ * Description: Rendered catalog responses shared by every connection, with live seat counts
+ *              filled in at send time.
+ */
+#include "response_cache.h"
+#include "catalog.h"
+#include <functional>
+
+static const size_t DEFAULT_SHARDS = 16;
+
+void CachedResponse::Builder::append(std::string_view text)
+{
+    if (text.empty())
+    {
+        return;
+    }
+    if (pieces_.empty() || pieces_.back().kind != Piece::Text)
+    {
+        pieces_.push_back({Piece::Text, text_.size(), 0, nullptr});
+    }
+    text_.append(text);
+    pieces_.back().length += text.size();
+}
+
+void CachedResponse::Builder::append_shared(const std::shared_ptr<const std::string> &buffer, std::string_view slice)
+{
+    if (slice.empty())
+    {
+        return;
+    }
+    if (!shared_)
+    {
+        shared_ = buffer;
+    }
+    if (shared_ != buffer)
+    {
+        append(slice);
+        return;
+    }
+    size_t offset = static_cast<size_t>(slice.data() - shared_->data());
+    if (!pieces_.empty() && pieces_.back().kind == Piece::Shared && pieces_.back().offset + pieces_.back().length == offset)
+    {
+        pieces_.back().length += slice.size();
+        return;
+    }
+    pieces_.push_back({Piece::Shared, offset, slice.size(), nullptr});
+}
+
+std::shared_ptr<const CachedResponse> CachedResponse::Builder::finish()
+{
+    auto response = std::make_shared<CachedResponse>();
+    response->text_ = std::make_shared<const std::string>(std::move(text_));
+    response->shared_ = std::move(shared_);
+    response->pieces_ = std::move(pieces_);
+    response->line_ = line_;
+    text_.clear();
+    shared_.reset();
+    pieces_.clear();
+    line_ = true;
+    return response;
+}
+
+void CachedResponse::send(OutputQueue &out) const
+{
+    for (const Builder::Piece &piece : pieces_)
+    {
+        switch (piece.kind)
+        {
+        case Builder::Piece::Text:
+            out.push(text_, std::string_view(*text_).substr(piece.offset, piece.length));
+            break;
+        case Builder::Piece::Shared:
+            out.push(shared_, std::string_view(*shared_).substr(piece.offset, piece.length));
+            break;
+        case Builder::Piece::Availability:
+        {
+            int seats = piece.seats->seats_available.load(std::memory_order_relaxed);
+            out.push((seats > 0 ? "Open, Seats: " : "Close, Seats: ") + std::to_string(seats));
+            break;
+        }
+        case Builder::Piece::Seats:
+            out.push(std::to_string(piece.seats->seats_available.load(std::memory_order_relaxed)));
+            break;
+        }
+    }
+    if (line_)
+    {
+        out.push_static("\n");
+    }
+}
+
+ResponseCache::ResponseCache(size_t shards, size_t capacity)
+    : shard_count_(shards != 0 ? shards : DEFAULT_SHARDS),
+      shard_capacity_(capacity == 0 ? 0 : (capacity + shard_count_ - 1) / shard_count_),
+      shards_(std::make_unique<Shard[]>(shard_count_))
+{
+}
+
+ResponseCache::Shard &ResponseCache::shard(std::string_view key)
+{
+    return shards_[std::hash<std::string_view>()(key) % shard_count_];
+}
+
+std::shared_ptr<const CachedResponse> ResponseCache::find(std::string_view key, uint64_t version)
+{
+    if (!enabled())
+    {
+        return nullptr;
+    }
+    Shard &owner = shard(key);
+    std::lock_guard guard(owner.lock);
+    auto found = owner.by_key.find(key);
+    if (found == owner.by_key.end())
+    {
+        owner.misses++;
+        return nullptr;
+    }
+    if (found->second->version != version)
+    {
+        // Rendered from another generation of the catalog; its slots and counters are not this one's
+        owner.entries.erase(found->second);
+        owner.by_key.erase(found);
+        owner.misses++;
+        return nullptr;
+    }
+    owner.entries.splice(owner.entries.begin(), owner.entries, found->second);
+    owner.hits++;
+    return found->second->response;
+}
+
+void ResponseCache::insert(std::string_view key, uint64_t version, std::shared_ptr<const CachedResponse> response)
+{
+    if (!enabled())
+    {
+        return;
+    }
+    Shard &owner = shard(key);
+    std::lock_guard guard(owner.lock);
+    auto found = owner.by_key.find(key);
+    if (found != owner.by_key.end())
+    {
+        // Another session rendered the same response meanwhile; keep the newer one
+        owner.entries.erase(found->second);
+        owner.by_key.erase(found);
+    }
+    while (owner.entries.size() >= shard_capacity_)
+    {
+        owner.by_key.erase(owner.entries.back().key);
+        owner.entries.pop_back();
+    }
+    owner.entries.push_front({std::string(key), version, std::move(response)});
+    owner.by_key.emplace(owner.entries.front().key, owner.entries.begin());
+}
+
+uint64_t ResponseCache::hits() const
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < shard_count_; i++)
+    {
+        std::lock_guard guard(shards_[i].lock);
+        total += shards_[i].hits;
+    }
+    return total;
+}
+
+uint64_t ResponseCache::misses() const
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < shard_count_; i++)
+    {
+        std::lock_guard guard(shards_[i].lock);
+        total += shards_[i].misses;
+    }
+    return total;
+}
@@ -0,0 +1,163 @@
+#ifndef RESPONSE_CACHE_H
+#define RESPONSE_CACHE_H
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "output_queue.h"
+
+struct SeatCounter;
+
+/**
+ * @class CachedResponse
+ * @brief A fully rendered response whose live seat numbers are left as holes.
+ *
+ * The text is shared, immutable and never copied: send() queues slices of it
+ * and formats only the seat numbers, read from the counters at send time, so a
+ * seat taken by ENROLL shows up without re-rendering the response. Parts of a
+ * response can also point into a shared buffer such as the catalog's
+ * CourseRecords, which keeps a LIST of the whole catalog down to a few slices.
+ */
+class CachedResponse
+{
+public:
+    enum class Hole : uint8_t
+    {
+        Seats,       // "N"
+        Availability // "Open, Seats: N" or "Close, Seats: N"
+    };
+
+    /**
+     * @class Builder
+     * @brief Renders a response piece by piece.
+     */
+    class Builder
+    {
+    public:
+        /**
+         * @brief Appends a copy of text.
+         */
+        void append(std::string_view text);
+
+        /**
+         * @brief Appends a slice of a shared buffer without copying it; a slice that continues the previous one extends it.
+         *
+         * A response references at most one shared buffer, and slices of any other are copied.
+         */
+        void append_shared(const std::shared_ptr<const std::string> &buffer, std::string_view slice);
+
+        /**
+         * @brief Leaves a hole for a course's live seat count.
+         * @param seats The course's counter. It must be alive whenever the response is sent, which holds
+         *              while the sender keeps a view of the catalog version the response was built from.
+         */
+        void hole(Hole kind, const SeatCounter &seats) { pieces_.push_back({static_cast<Piece::Kind>(kind), 0, 0, &seats}); }
+
+        /**
+         * @brief Marks the response as a binary protocol frame, which send() queues without a trailing newline.
+         */
+        void frame() { line_ = false; }
+
+        std::shared_ptr<const CachedResponse> finish();
+
+    private:
+        friend class CachedResponse;
+        struct Piece
+        {
+            enum Kind : uint8_t
+            {
+                Seats = static_cast<uint8_t>(Hole::Seats),
+                Availability = static_cast<uint8_t>(Hole::Availability),
+                Text,  // [offset, offset + length) of the response's own text
+                Shared // [offset, offset + length) of the shared buffer
+            };
+            Kind kind;
+            size_t offset;
+            size_t length;
+            const SeatCounter *seats;
+        };
+        std::string text_;
+        std::shared_ptr<const std::string> shared_;
+        std::vector<Piece> pieces_;
+        bool line_ = true;
+    };
+
+    /**
+     * @brief Queues the response, with the current seat counts filled in, followed by a newline unless it is a frame.
+     */
+    void send(OutputQueue &out) const;
+
+private:
+    std::shared_ptr<const std::string> text_;
+    std::shared_ptr<const std::string> shared_;
+    std::vector<Builder::Piece> pieces_;
+    bool line_ = true;
+};
+
+/**
+ * @class ResponseCache
+ * @brief A sharded LRU cache of rendered LIST, SEARCH and SHOW responses and binary PREREQS frames, keyed by normalized command.
+ *
+ * Every entry is tagged with the catalog version it was rendered from and is
+ * only returned for that version, so a reload invalidates the whole cache at
+ * once without touching it; stale entries are dropped as they are found or
+ * pushed out. Seat changes invalidate nothing, since seats are holes filled in
+ * at send time. Keys are spread over independently locked shards, each with its
+ * own LRU list, so sessions browsing different subjects do not contend.
+ */
+class ResponseCache
+{
+public:
+    /**
+     * @param shards The number of shards; 0 picks a default of 16.
+     * @param capacity The total number of responses kept; 0 turns the cache off.
+     */
+    ResponseCache(size_t shards, size_t capacity);
+
+    /**
+     * @brief The cached response for a key, if it was rendered from this catalog version.
+     */
+    std::shared_ptr<const CachedResponse> find(std::string_view key, uint64_t version);
+
+    /**
+     * @brief Caches a response, evicting the shard's least recently used entry if it is full.
+     */
+    void insert(std::string_view key, uint64_t version, std::shared_ptr<const CachedResponse> response);
+
+    bool enabled() const { return shard_capacity_ > 0; }
+
+    /**
+     * @brief Lookups answered from the cache and lookups that were not, for reports.
+     */
+    uint64_t hits() const;
+    uint64_t misses() const;
+
+private:
+    struct Entry
+    {
+        std::string key;
+        uint64_t version;
+        std::shared_ptr<const CachedResponse> response;
+    };
+
+    struct alignas(64) Shard
+    {
+        mutable std::mutex lock;
+        std::list<Entry> entries; // Most recently used first
+        std::unordered_map<std::string_view, std::list<Entry>::iterator> by_key; // Keys point into entries
+        uint64_t hits = 0, misses = 0;
+    };
+
+    Shard &shard(std::string_view key);
+
+    size_t shard_count_;
+    size_t shard_capacity_;
+    std::unique_ptr<Shard[]> shards_;
+};
+
+#endif // RESPONSE_CACHE_H
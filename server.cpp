@@ -24,6 +24,8 @@
 #include <system_error>
 #include <map>
 #include <fstream>
+#include <functional>
+#include <memory>
 
 // C headers for socket API
 #include <stdio.h>
@@ -37,387 +39,859 @@
 #include <sys/wait.h>
 #include <signal.h>
 #include "p1_helper.h"
+#include "catalog.h"
+#include "catalog_watcher.h"
+#include "binary_protocol.h"
+#include "command_parser.h"
+#include "registrar.h"
+#include "request_arena.h"
+#include "response_cache.h"
+#include "session.h"
+#include "event_loop.h"
+#include "thread_pool.h"
+#include "line_buffer.h"
 using namespace std;
 
 // #define PORT "3490"
 #define BACKLOG 10
 #define MAXDATASIZE 1000
 
-std::string coursesToString(std::vector<Course> courses)
+// LIST and SEARCH paging: results per page without SIZE, and the most SIZE may ask for
+#define PAGE_SIZE_DEFAULT 50
+#define PAGE_SIZE_MAX 1000
+// Unpaged LIST and SEARCH replies with more courses than this are streamed instead of cached
+#define STREAM_MIN_COURSES 1024
+#define STREAM_PART_BYTES (64 * 1024)
+
+// Appends the pre-rendered LIST line of every slot; lines of consecutive slots become one slice of the records
+void appendCourseList(CachedResponse::Builder &output, const Catalog::View &view, const std::vector<uint32_t> &slots)
 {
-  std::stringstream output;
-  for (Course course : courses)
+  const CourseRecords &records = view.records();
+  for (uint32_t slot : slots)
   {
-    output << course.course_code << " " << course.title << "\n";
+    output.append_shared(records.arena(), records.list_line(slot));
   }
-  return output.str();
 }
 
-std::string courseToString(Course course)
+// Appends the pre-rendered SHOW details of a course, leaving its live seat count as a hole
+void appendCourse(CachedResponse::Builder &output, const Catalog::View &view, uint32_t slot)
 {
-  std::stringstream output;
-  output << "Course Code: " << course.course_code << endl;
-  output << "Title: " << course.title << endl;
-  output << "Subject: " << course.subject << endl;
-  output << "Instructor: " << course.instructor << endl;
-  output << "Seat Capacity: " << course.capacity << endl;
-  output << "Available Seats: " << course.seats_available << endl;
-  output << "Prereqs: ";
-
-  for (int i = 0; i < course.prerequisites.size(); i++)
-  {
-    string prereq = course.prerequisites[i];
-    output << prereq;
-    if (i != course.prerequisites.size() - 1)
-    {
-      output << ", ";
-    }
+  const CourseRecords &records = view.records();
+  output.append_shared(records.arena(), records.show_head(slot));
+  output.hole(CachedResponse::Hole::Seats, view.seats(slot));
+  output.append_shared(records.arena(), records.show_tail(slot));
+}
+
+// Helper function to get sockaddr, IPv4 or IPv6:
+void *get_in_addr(struct sockaddr *sa)
+{
+  if (sa->sa_family == AF_INET)
+  {
+    return &(((struct sockaddr_in *)sa)->sin_addr);
   }
-  output << endl;
-  output << "Description: " << course.description << endl;
-  return output.str();
+  return &(((struct sockaddr_in6 *)sa)->sin6_addr);
+}
+
+// Queues a reply; the I/O path writes all queued replies together once the received commands are handled
+void send_back(Session &session, string message)
+{
+  session.out.push(std::move(message));
+  session.out.push_static("\n");
+}
+
+// Queues a fixed reply without copying it
+void send_back(Session &session, const char *message)
+{
+  session.out.push_static(message);
+  session.out.push_static("\n");
+}
+
+// Queues the cached reply for a normalized command, rendering and caching it first on a miss.
+// The reply is shared with every other session that asks the same thing of the same catalog version.
+template <typename Render>
+void send_cached(Session &session, ResponseCache &cache, const Catalog::View &view, string_view key, const Render &render)
+{
+  shared_ptr<const CachedResponse> response = cache.find(key, view.version());
+  if (!response)
+  {
+    CachedResponse::Builder builder;
+    render(builder);
+    response = builder.finish();
+    cache.insert(key, view.version(), response);
+  }
+  response->send(session.out);
 }
 
-bool isOption(string command)
+// Writes the HELP text for the session's mode
+string helpText(Mode mode)
 {
-  if (command == "HELP" || command == "CATALOG" || command == "ENROLLMENT" || command == "MYCOURSES" || command == "LIST" || command == "VIEWGRADES" || command == "BYE" || (command.find("LIST") != string::npos) || (command.find("SEARCH") != string::npos) || (command.find("SHOW") != string::npos) || (command.find("ENROLL") != string::npos) || (command.find("DROP") != string::npos))
+  stringstream output;
+  output << "200 Possible Commands: " << endl;
+  switch (mode)
   {
-    return true;
+  case Mode::Enrollment:
+    output << "\tENROLL <course_code> - This command enrolls a client in a course. The server replies with 250 on success, 403 if the course is full, or 404 if the course is not found. Prerequisites for a course are considered met if prerequisite course(s) are listed in the current enrollment history." << endl;
+    output << "\tELIGIBLE - This command lists every course the client can enroll in: its prerequisites are all in the current enrollment and the client is not enrolled in it yet. The server replies with 250 and the list of courses, or 304 if there are none." << endl;
+    output << "\tDROP <course_code> - This command allows a client to drop a course. The server replies with 250 on success or 404 if the course was not enrolled by the client. Dropping a course removes it from the student\’s active enrollment." << endl;
+    break;
+  case Mode::Catalog:
+    output << "\tLIST [filter] - The LIST command lists all available courses, optionally filtered by subject, instructor, or course - code.The server replies with 250 and the list of courses, or 304 if no courses are available." << endl;
+    output << "\tSEARCH <filter> <search-term> - The SEARCH command searches for courses by a specified <filter> (subject, instructor, or course-code) and <search-term>. The server replies with 250 and a list of matching courses, or 304 if none are found." << endl;
+    output << "\tSEARCH <title|description|keyword> <words> - Finds courses whose title, description, or any text field contains every word (case-insensitive). End a word with * to match it as a prefix, e.g. SEARCH keyword calc* intro. A search-term with other punctuation, e.g. SEARCH title I/O, is matched as an exact substring." << endl;
+    output << "\tLIST|SEARCH ... PAGE <n> [SIZE <k>] - Adding PAGE to a LIST or SEARCH returns only the n-th page of its results, k courses per page (50 by default, at most 1000). The reply starts with 250 Page n of m, or is 304 if the page is past the end." << endl;
+    output << "\tSHOW <course_code> [availability] - The SHOW command displays details for a specific course. When the optional [availability] argument is included, the server should only list the course\’s availability status and the number of available seats. Without the optional argument, the server should provide the full course description. The server replies with 250 and the requested details, or 404 if the course is not found." << endl;
+    output << "\tSHOW <course_code> prereqs - Lists every course that must be taken before this one, directly or through other prerequisites, in an order they could be taken. The server replies with 250 and the chain, or 404 if the course is not found." << endl;
+    break;
+  case Mode::MyCourses:
+    output << "\tLIST - This command displays the student\’s current enrollment (and by that virtue the history). The server replies with 250 and the list of courses, or 304 if no courses are found." << endl;
+    output << "\tVIEWGRADES - This command shows the student\’s grades for completed courses. The server replies with 250 or 304 if no grades are available." << endl;
+    break;
+  case Mode::None:
+    output << "\tCATALOG - This command enables clients to access the course catalog. Success is acknowledged by server reply code is 210. " << endl;
+    output << "\tENROLLMENT - This command allows clients to enroll in or drop courses. The server\’s reply code is 220. " << endl;
+    output << "\tMYCOURSES - This mode provides clients with functionalities to manage their academic schedules. The correct server reply code is 230. " << endl;
+    output << "\tBYE - This command closes the connection and requests a graceful exit. The server\’s reply code is 200." << endl;
+    return output.str();
   }
 
-  return false;
+  output << endl
+         << "SWITCH MODE:" << endl;
+  output << (mode == Mode::Catalog ? "" : "\tCATALOG - This command enables clients to access the course catalog. Success is acknowledged by server reply code is 210. \n");
+  output << (mode == Mode::Enrollment ? "" : "\tENROLLMENT - This command allows clients to enroll in or drop courses. The server\’s reply code is 220. \n");
+  output << (mode == Mode::MyCourses ? "" : "\tMYCOURSES - This mode provides clients with functionalities to manage their academic schedules. The correct server reply code is 230. \n");
+  output
+      << endl
+      << "\tBYE - This command closes the connection and requests a graceful exit. The server\’s reply code is 200." << endl;
+  return output.str();
 }
 
-// Helper function to get sockaddr, IPv4 or IPv6:
-void *get_in_addr(struct sockaddr *sa)
+// Builds a response cache key from a verb and its normalized arguments, in the command's arena
+std::pmr::string cacheKey(Session &session, string_view verb, string_view first, string_view second, const Page &page = Page())
 {
-  if (sa->sa_family == AF_INET)
+  std::pmr::string key(session.arena.resource());
+  key.reserve(verb.size() + first.size() + second.size() + 2);
+  key.append(verb).append("\x1f").append(first).append("\x1f").append(second);
+  if (page.number > 0)
   {
-    return &(((struct sockaddr_in *)sa)->sin_addr);
+    key.append("\x1f").append(to_string(page.number)).append("\x1f").append(to_string(page.size));
   }
-  return &(((struct sockaddr_in6 *)sa)->sin6_addr);
+  return key;
 }
 
-void send_back(int pid, string message)
+// The results [first, last) of a page of count results, or all of them without a page; empty if the page is past the end
+void pageBounds(size_t count, const Page &page, size_t &first, size_t &last)
 {
-  std::string msg_str = message + "\n";
-  const char *msg = msg_str.c_str();
-  if (send(pid, msg, strlen(msg), 0) == -1)
+  first = 0;
+  last = count;
+  if (page.number > 0)
   {
-    perror("send");
+    first = page.number - 1 <= count / page.size ? min(count, (page.number - 1) * page.size) : count;
+    last = min(count, first + page.size);
   }
 }
 
-int message_handler(int pid, string message, string &mode, vector<Course> &courses, vector<string> &enrollmentHistory)
+// Queues the LIST lines of the results [first, last) part by part as the socket takes them, so a
+// reply of any size holds at most STREAM_PART_BYTES of slices at a time. Without a result vector
+// the results are every course in catalog order. The view keeps the records alive until the end.
+void streamCourseList(Session &session, const Catalog::View &view, shared_ptr<const vector<uint32_t>> slots, size_t first, size_t last)
 {
-  try
+  session.out.push_producer([view, slots, next = first, last](OutputQueue &part) mutable
+                            {
+                              const CourseRecords &records = view.records();
+                              string_view run;
+                              size_t bytes = 0;
+                              for (; next < last && bytes < STREAM_PART_BYTES; next++)
+                              {
+                                string_view line = records.list_line(slots ? (*slots)[next] : next);
+                                bytes += line.size();
+                                // Lines of consecutive courses follow each other in the records
+                                if (run.data() + run.size() == line.data())
+                                {
+                                  run = string_view(run.data(), run.size() + line.size());
+                                  continue;
+                                }
+                                part.push(records.arena(), run);
+                                run = line;
+                              }
+                              part.push(records.arena(), run);
+                              if (next < last)
+                              {
+                                return true;
+                              }
+                              part.push_static("\n");
+                              return false; });
+}
+
+// Sends a LIST or SEARCH reply: the header and the matching courses, or one page of them.
+// Large unpaged replies are streamed and not cached; everything else goes through the cache.
+void sendCourseList(Session &session, ResponseCache &cache, const Catalog::View &view, const std::pmr::string &key, const char *header, string_view filter, string_view search_term, const Page &page)
+{
+  if (shared_ptr<const CachedResponse> response = cache.find(key, view.version()))
   {
-    if (!isOption(message))
+    response->send(session.out);
+    return;
+  }
+
+  // Every course in catalog order needs no result vector
+  shared_ptr<const vector<uint32_t>> slots;
+  size_t count = view.size();
+  if (filter != "ALL")
+  {
+    slots = make_shared<const vector<uint32_t>>(view.search(filter, search_term));
+    count = slots->size();
+  }
+  size_t first, last;
+  pageBounds(count, page, first, last);
+
+  CachedResponse::Builder output;
+  if (first == last)
+  {
+    output.append("304 No classes found!");
+  }
+  else if (page.number == 0 && count > STREAM_MIN_COURSES)
+  {
+    session.out.push_static(header);
+    streamCourseList(session, view, std::move(slots), first, last);
+    return;
+  }
+  else
+  {
+    if (page.number > 0)
     {
-      send_back(pid, "400 Command not avaliable!");
-      return 1;
+      output.append("250 Page " + to_string(page.number) + " of " + to_string((count + page.size - 1) / page.size) + " (" + to_string(count) + " courses)\n");
     }
-    else if (message == "BYE")
+    else
     {
-      send_back(pid, "200 BYE");
-      return 0;
+      output.append(header);
     }
-    else if (message == "HELP")
+    const CourseRecords &records = view.records();
+    for (size_t i = first; i < last; i++)
     {
-      stringstream output;
-      output << "200 Possible Commands: " << endl;
-      if (mode == "ENROLLMENT")
-      {
-        output << "\tENROLL <course_code> - This command enrolls a client in a course. The server replies with 250 on success, 403 if the course is full, or 404 if the course is not found. Prerequisites for a course are considered met if prerequisite course(s) are listed in the current enrollment history." << endl;
-        output << "\tDROP <course_code> - This command allows a client to drop a course. The server replies with 250 on success or 404 if the course was not enrolled by the client. Dropping a course removes it from the student\’s active enrollment." << endl;
-      }
-      else if (mode == "CATALOG")
-      {
-        output << "\tLIST [filter] - The LIST command lists all available courses, optionally filtered by subject, instructor, or course - code.The server replies with 250 and the list of courses, or 304 if no courses are available." << endl;
-        output << "\tSEARCH <filter> <search-term> - The SEARCH command searches for courses by a specified <filter> (subject, instructor, or course-code) and <search-term>. The server replies with 250 and a list of matching courses, or 304 if none are found." << endl;
-        output << "\tSHOW <course_code> [availability] - The SHOW command displays details for a specific course. When the optional [availability] argument is included, the server should only list the course\’s availability status and the number of available seats. Without the optional argument, the server should provide the full course description. The server replies with 250 and the requested details, or 404 if the course is not found." << endl;
-      }
-      else if (mode == "MYCOURSES")
-      {
-        output << "\tLIST - This command displays the student\’s current enrollment (and by that virtue the history). The server replies with 250 and the list of courses, or 304 if no courses are found." << endl;
-        output << "\tVIEWGRADES - This command shows the student\’s grades for completed courses. The server replies with 250 or 304 if no grades are available." << endl;
-      }
-      else
-      {
-        output << "\tCATALOG - This command enables clients to access the course catalog. Success is acknowledged by server reply code is 210. " << endl;
-        output << "\tENROLLMENT - This command allows clients to enroll in or drop courses. The server\’s reply code is 220. " << endl;
-        output << "\tMYCOURSES - This mode provides clients with functionalities to manage their academic schedules. The correct server reply code is 230. " << endl;
-        output << "\tBYE - This command closes the connection and requests a graceful exit. The server\’s reply code is 200." << endl;
-        send_back(pid, output.str());
-        return 1;
-      }
-
-      
-      output << endl
-             << "SWITCH MODE:" << endl;
-      output << (mode == "CATALOG" ? "" : "\tCATALOG - This command enables clients to access the course catalog. Success is acknowledged by server reply code is 210. \n");
-      output << (mode == "ENROLLMENT" ? "" : "\tENROLLMENT - This command allows clients to enroll in or drop courses. The server\’s reply code is 220. \n");
-      output << (mode == "MYCOURSES" ? "" : "\tMYCOURSES - This mode provides clients with functionalities to manage their academic schedules. The correct server reply code is 230. \n");
-      output
-          << endl
-          << "\tBYE - This command closes the connection and requests a graceful exit. The server\’s reply code is 200." << endl;
-
-      send_back(pid, output.str());
-      return 1;
+      output.append_shared(records.arena(), records.list_line(slots ? (*slots)[i] : i));
     }
-    else if (message == "CATALOG")
+  }
+  shared_ptr<const CachedResponse> response = output.finish();
+  cache.insert(key, view.version(), response);
+  response->send(session.out);
+}
+
+// Handles one text command. The line is tokenized once into string_views and dispatched on its verb;
+// each verb then checks the session's mode, so no command is matched by searching the line for a keyword.
+int message_handler(Session &session, string_view message, Catalog &catalog, Registrar &registrar, ResponseCache &cache)
+{
+  Mode &mode = session.mode;
+  StudentStore &students = registrar.students();
+  try
+  {
+    Command command = parse_command(message);
+    string_view arguments = command.arguments;
+    switch (command.verb)
     {
-      mode = "CATALOG";
-      send_back(pid, "210 Switched to CATALOG Mode");
+    case Verb::Unknown:
+      send_back(session, "400 Command not avaliable!");
       return 1;
-    }
-    else if (message == "ENROLLMENT")
-    {
-      mode = "ENROLLMENT";
-      send_back(pid, "220 Switched to ENROLLMENT Mode");
+    case Verb::Bye:
+      send_back(session, "200 BYE");
+      return 0;
+    case Verb::Help:
+      send_back(session, helpText(mode));
       return 1;
-    }
-    else if (message == "MYCOURSES")
-    {
-      mode = "MYCOURSES";
-      send_back(pid, "230 Switched to MYCOURSES Mode");
+    case Verb::Binary:
+      // Every later message is a frame; the client waits for this reply before sending one
+      send_back(session, "200 BINARY");
+      session.binary.store(true, std::memory_order_release);
+      return 1;
+    case Verb::Catalog:
+      mode = Mode::Catalog;
+      students.set_mode(session.student, mode_name(mode));
+      send_back(session, "210 Switched to CATALOG Mode");
       return 1;
+    case Verb::Enrollment:
+      mode = Mode::Enrollment;
+      students.set_mode(session.student, mode_name(mode));
+      send_back(session, "220 Switched to ENROLLMENT Mode");
+      return 1;
+    case Verb::MyCourses:
+      mode = Mode::MyCourses;
+      students.set_mode(session.student, mode_name(mode));
+      send_back(session, "230 Switched to MYCOURSES Mode");
+      return 1;
+    default:
+      break;
     }
-    else if (mode == "NO MODE")
+
+    if (mode == Mode::None)
     {
-      send_back(pid, "503 Bad sequence of commands. Must enter a mode first.");
+      send_back(session, "503 Bad sequence of commands. Must enter a mode first.");
       return 1;
     }
-    else if ((message.find("SEARCH") != string::npos))
-    {
-      if (mode == "CATALOG")
-      {
-        string filter, search_term;
-        message.erase(0, message.find(" ") + 1);
-        filter = message.substr(0, message.find(" "));
-        message.erase(0, message.find(" ") + 1);
-        search_term = message.substr(0, message.find(" "));
-        if (filter == "" || search_term == "")
-        {
-          send_back(pid, "400 NEED FILTER AND SEARCH TERM");
-          return 1;
-        }
 
-        vector<Course> returnedCourses = search_courses(courses, filter, search_term);
-        if (returnedCourses.size() == 0)
-        {
-          send_back(pid, "304 No classes found!");
-          return 1;
-        }
-        std::stringstream output;
-        output << "250" << "\n";
-
-        for (Course course : returnedCourses)
-        {
-          output << course.course_code << " " << course.title << "\n";
-        }
-
-        send_back(pid, output.str());
+    switch (command.verb)
+    {
+    case Verb::Search:
+    {
+      if (mode != Mode::Catalog)
+      {
+        send_back(session, "400 Need to switch to the CATALOG MODE!");
         return 1;
       }
-      else
+      Page page;
+      if (!take_page(arguments, page, PAGE_SIZE_DEFAULT, PAGE_SIZE_MAX))
       {
-        send_back(pid, "400 Need to switch to the CATALOG MODE!");
+        send_back(session, "400 BAD PAGE OR SIZE");
         return 1;
       }
+      string_view filter = next_word(arguments);
+      // Word filters take every remaining word, the substring filters only the first
+      bool wordFilter = filter == "title" || filter == "description" || filter == "keyword";
+      string_view search_term = wordFilter ? arguments : next_word(arguments);
+      if (filter.empty() || search_term.empty())
+      {
+        send_back(session, "400 NEED FILTER AND SEARCH TERM");
+        return 1;
+      }
+
+      Catalog::View view = catalog.view();
+      sendCourseList(session, cache, view, cacheKey(session, "SEARCH", filter, search_term, page), "250\n", filter, search_term, page);
+      return 1;
     }
-    else if (message.find("LIST") != string::npos)
-    {
-      if (mode == "CATALOG")
+    case Verb::List:
+      if (mode == Mode::Catalog)
       {
-        string filter = "ALL";
-        string search_term = "";
-        if (message.find(" ") != string::npos)
+        Page page;
+        if (!take_page(arguments, page, PAGE_SIZE_DEFAULT, PAGE_SIZE_MAX))
         {
-          message.erase(0, message.find(" ") + 1);
-          filter = message.substr(0, message.find(" "));
-          message.erase(0, message.find(" ") + 1);
-          search_term = message.substr(0, message.find(" "));
+          send_back(session, "400 BAD PAGE OR SIZE");
+          return 1;
         }
-        vector<Course> courseList = search_courses(courses, filter, search_term);
-
-        if (courseList.size() == 0)
+        string_view filter = "ALL";
+        string_view search_term;
+        if (!arguments.empty())
         {
-          send_back(pid, "304 No classes found!");
-          return 1;
+          filter = next_word(arguments);
+          search_term = next_word(arguments);
         }
-
-        string courseString = "250 \n" + coursesToString(courseList);
-
-        send_back(pid, courseString);
+        Catalog::View view = catalog.view();
+        sendCourseList(session, cache, view, cacheKey(session, "LIST", filter, search_term, page), "250 \n", filter, search_term, page);
         return 1;
       }
-      else if (mode == "MYCOURSES")
+      else if (mode == Mode::MyCourses)
       {
+        auto enrollmentHistory = students.enrollments(session.student, session.arena.resource());
         if (enrollmentHistory.size() == 0)
         {
-          send_back(pid, "304 NO CONTENT you haven't enrolled in any classes!");
+          send_back(session, "304 NO CONTENT you haven't enrolled in any classes!");
           return 1;
         }
         stringstream output;
         output << "250 Enrollment Histroy:" << endl;
-        for (string course : enrollmentHistory)
+        for (const auto &course : enrollmentHistory)
         {
           output << "\t" << course << endl;
         }
-        send_back(pid, output.str());
+        send_back(session, output.str());
         return 1;
       }
-      else
+      send_back(session, "400 Need to switch to the CATALOG OR MYCOURSES MODE!");
+      return 1;
+    case Verb::Show:
+    {
+      if (mode != Mode::Catalog)
       {
-        send_back(pid, "400 Need to switch to the CATALOG OR MYCOURSES MODE!");
+        send_back(session, "400 Need to switch to the CATALOG MODE!");
         return 1;
       }
+      string_view course_code = next_word(arguments);
+      string_view availability = arguments;
+
+      Catalog::View view = catalog.view();
+      send_cached(session, cache, view, cacheKey(session, "SHOW", course_code, availability), [&](CachedResponse::Builder &output)
+                  {
+                    int slot = view.find(course_code);
+                    if (slot == -1)
+                    {
+                      output.append("304 No Class Found!");
+                      return;
+                    }
+                    output.append("250");
+                    if (availability == "prereqs")
+                    {
+                      // Walked over the condensed graph built at load time; the reply is cached like any SHOW
+                      const PrerequisiteGraph &graph = view.prerequisites();
+                      vector<uint32_t> chain = graph.chain(slot);
+                      output.append(" Prereqs for ");
+                      output.append(view.table().course_code(slot));
+                      output.append(":");
+                      for (uint32_t before : chain)
+                      {
+                        output.append(" ");
+                        output.append(view.table().course_code(before));
+                      }
+                      if (chain.empty())
+                      {
+                        output.append(" None");
+                      }
+                      if (graph.blocked_by_cycle(slot))
+                      {
+                        output.append(" (prerequisite cycle, cannot be taken)");
+                      }
+                      if (graph.incomplete(slot))
+                      {
+                        output.append(" (some prerequisites are not in the catalog)");
+                      }
+                    }
+                    else if (availability == "availability")
+                    {
+                      output.append(" Availability ");
+                      output.hole(CachedResponse::Hole::Availability, view.seats(slot));
+                    }
+                    else
+                    {
+                      output.append("\n");
+                      appendCourse(output, view, slot);
+                    } });
+      return 1;
     }
-    else if (message.find("SHOW") != string::npos)
+    case Verb::Eligible:
     {
-      if (mode == "CATALOG")
+      if (mode != Mode::Enrollment)
       {
-        message.erase(0, message.find(" ") + 1);
-        string course_code, availability = "";
-        if (message.find(" ") != string::npos)
-        {
-          course_code = message.substr(0, message.find(" "));
-          message.erase(0, message.find(" ") + 1);
-          availability = message;
-        }
-        else
-        {
-          course_code = message;
-        }
-
-        Course course = get_course_by_code(courses, course_code);
-
-        if (course.title == "")
-        {
-          send_back(pid, "304 No Class Found!");
-          return 1;
-        }
-
-        stringstream output;
-        output << "250";
-        if (availability == "availability")
-        {
-          output << " Availability " << (course.seats_available > 0 ? "Open, " : "Close, ") << "Seats: " << course.seats_available;
-        }
-        else
-        {
-          output << endl
-                 << courseToString(course);
-        }
-        send_back(pid, output.str());
+        send_back(session, "400 Need to switch to the ENROLLMENT MODE!");
         return 1;
       }
-      else
+      Catalog::View view = catalog.view();
+      vector<uint32_t> eligible = view.prerequisites().eligible_courses(view.course_set(students.enrollments(session.student, session.arena.resource())));
+      if (eligible.empty())
       {
-        send_back(pid, "400 Need to switch to the CATALOG MODE!");
+        send_back(session, "304 No eligible courses found!");
         return 1;
       }
+      // Depends on the student's courses, so it is assembled from the records but not cached
+      CachedResponse::Builder output;
+      output.append("250 \n");
+      appendCourseList(output, view, eligible);
+      output.finish()->send(session.out);
+      return 1;
     }
-    else if (message.find("ENROLL") != string::npos)
+    case Verb::Enroll:
     {
-      if (mode != "ENROLLMENT")
+      if (mode != Mode::Enrollment)
       {
-        send_back(pid, "400 Need to switch to the ENROLLMENT MODE!");
+        send_back(session, "400 Need to switch to the ENROLLMENT MODE!");
         return 1;
       }
-      string course_code;
-      message.erase(0, message.find(" ") + 1);
-      course_code = message;
-      Course course = get_course_by_code(courses, course_code);
-      if (course.title == "NOT FOUND")
+      string_view course_code = arguments;
+      Catalog::View view = catalog.view();
+      int slot = view.find(course_code);
+      if (slot == -1)
       {
-        send_back(pid, "404 NOT FOUND. Course Not Found.");
+        send_back(session, "404 NOT FOUND. Course Not Found.");
         return 1;
       }
-      for (string prereq : course.prerequisites)
+      // Prerequisites are met when the student's courses, as a bitset over the catalog, cover the course's requirement
+      if (!view.prerequisites().eligible(slot, view.course_set(students.enrollments(session.student, session.arena.resource()))))
       {
-        bool found = false;
-        for (string taken : enrollmentHistory)
-        {
-          if (prereq == taken)
-          {
-            found = true;
-            break;
-          }
-        }
-        if (!found)
-        {
-          send_back(pid, "403 FORBIDDEN. Prerequisites not met.");
-          return 1;
-        }
+        send_back(session, "403 FORBIDDEN. Prerequisites not met.");
+        return 1;
+      }
+      switch (registrar.enroll(session.student, string(course_code), view.seats(slot)))
+      {
+      case Registrar::Result::AlreadyEnrolled:
+        send_back(session, "403 FORBIDDEN. Already enrolled in course.");
+        return 1;
+      case Registrar::Result::CourseFull:
+        send_back(session, "403 FORBIDDEN. Course is full.");
+        return 1;
+      case Registrar::Result::Ok:
+        break;
+      default:
+        send_back(session, "500 INTERNAL SERVER ERROR");
+        return 1;
       }
 
-      enrollmentHistory.push_back(course_code);
-
-      send_back(pid, "250 ENROLLMENT SUCCESSFUL.");
+      send_back(session, "250 ENROLLMENT SUCCESSFUL.");
       return 1;
     }
-    else if (message.find("DROP") != string::npos)
-    {
-      if (mode != "ENROLLMENT")
+    case Verb::Drop:
+      if (mode != Mode::Enrollment)
+      {
+        send_back(session, "400 Need to switch to the ENROLLMENT MODE!");
+        return 1;
+      }
+      switch (registrar.drop(session.student, string(arguments)))
       {
-        send_back(pid, "400 Need to switch to the ENROLLMENT MODE!");
+      case Registrar::Result::Ok:
+        send_back(session, "250 Dropped course.");
+        return 1;
+      case Registrar::Result::NotEnrolled:
+        send_back(session, "404 NOT FOUND. Class not found in enrollment history.");
+        return 1;
+      default:
+        send_back(session, "500 INTERNAL SERVER ERROR");
         return 1;
       }
-      message.erase(0, message.find(" ") + 1);
+    case Verb::ViewGrades:
+      send_back(session, "304 NO CONTENT. No grades found.");
+      return 1;
+    default:
+      send_back(session, "400 BAD REQUEST");
+      return 1;
+    }
+  }
+  catch (...)
+  {
+    send_back(session, "500 INTERNAL SERVER ERROR");
+    return 1;
+  }
+}
+
+// Appends the fixed-layout course summary of a slot (see binary_protocol.h)
+void putCourseSummary(FrameWriter &frame, const Catalog::View &view, uint32_t slot)
+{
+  const CourseTable &table = view.table();
+  string_view code = table.course_code(slot).substr(0, UINT16_MAX), title = table.title(slot).substr(0, UINT16_MAX);
+  frame.i32(view.seats_available(slot));
+  frame.i32(table.capacity(slot));
+  frame.u16(code.size());
+  frame.u16(title.size());
+  frame.bytes(code);
+  frame.bytes(title);
+}
+
+void putCourseSummaries(FrameWriter &frame, const Catalog::View &view, const vector<uint32_t> &slots, size_t first = 0, size_t last = SIZE_MAX)
+{
+  last = min(last, slots.size());
+  frame.u32(last - first);
+  for (size_t i = first; i < last; i++)
+  {
+    putCourseSummary(frame, view, slots[i]);
+  }
+}
+
+// Queues a binary LIST or SEARCH reply of every result, writing the summaries part by part as the
+// socket takes them, like streamCourseList(). The frame's length is summed from the codes and titles first.
+void streamCourseSummaries(Session &session, const Catalog::View &view, uint8_t opcode, shared_ptr<const vector<uint32_t>> slots)
+{
+  const CourseTable &table = view.table();
+  size_t summaries = 0;
+  for (uint32_t slot : *slots)
+  {
+    summaries += 12 + min<size_t>(table.course_code(slot).size(), UINT16_MAX) + min<size_t>(table.title(slot).size(), UINT16_MAX);
+  }
+  FrameWriter head;
+  head.u16(250);
+  head.u8(opcode);
+  head.u32(slots->size());
+  session.out.push(head.finish(summaries));
+  session.out.push_producer([view, slots, next = size_t(0)](OutputQueue &part) mutable
+                            {
+                              FrameWriter frame;
+                              for (; next < slots->size() && frame.position() < STREAM_PART_BYTES; next++)
+                              {
+                                putCourseSummary(frame, view, (*slots)[next]);
+                              }
+                              part.push(frame.continuation());
+                              return next < slots->size(); });
+}
+
+// Handles one frame of the binary protocol (see binary_protocol.h). Returns 0 to close the connection.
+int binary_message_handler(Session &session, const string &request, Catalog &catalog, Registrar &registrar, ResponseCache &cache)
+{
+  FrameReader reader(request);
+  uint8_t opcode = 0;
+  string_view first, second;
+  FrameWriter reply;
+  auto replyWith = [&](uint16_t status, string_view message)
+  {
+    reply.u16(status);
+    reply.u8(opcode);
+    reply.bytes(message);
+    session.out.push(reply.finish());
+    return 1;
+  };
+  if (!reader.u8(opcode))
+  {
+    return replyWith(400, "Empty or oversized frame");
+  }
+  // Every opcode takes up to two strings, which LIST and SEARCH may follow with a page number and size
+  if (!reader.at_end() && !reader.string(first))
+  {
+    return replyWith(400, "Malformed frame");
+  }
+  if (!reader.at_end() && !reader.string(second))
+  {
+    return replyWith(400, "Malformed frame");
+  }
+  bool pageable = static_cast<Opcode>(opcode) == Opcode::List || static_cast<Opcode>(opcode) == Opcode::Search;
+  uint32_t pageNumber = 0, pageSize = 0;
+  if (!reader.at_end() && (!pageable || !reader.u32(pageNumber) || !reader.u32(pageSize) || !reader.at_end()))
+  {
+    return replyWith(400, "Malformed frame");
+  }
 
-      for (int i = 0; i < enrollmentHistory.size(); i++)
+  try
+  {
+    Catalog::View view = catalog.view();
+    StudentStore &students = registrar.students();
+    string code(first);
+    int slot = view.find(code);
+    switch (static_cast<Opcode>(opcode))
+    {
+    case Opcode::Bye:
+      replyWith(200, "BYE");
+      return 0;
+    case Opcode::List:
+    case Opcode::Search:
+    {
+      if (static_cast<Opcode>(opcode) == Opcode::Search && (first.empty() || second.empty()))
       {
-        if (message == enrollmentHistory[i])
+        return replyWith(400, "NEED FILTER AND SEARCH TERM");
+      }
+      Page page;
+      if (pageNumber > 0)
+      {
+        page.number = pageNumber;
+        page.size = pageSize == 0 ? PAGE_SIZE_DEFAULT : pageSize;
+        if (page.size > PAGE_SIZE_MAX)
         {
-          enrollmentHistory.erase(enrollmentHistory.begin() + i);
-          send_back(pid, "250 Dropped course.");
-          return 1;
+          return replyWith(400, "BAD PAGE OR SIZE");
         }
       }
-      send_back(pid, "404 NOT FOUND. Class not found in enrollment history.");
-      return 1;
+      auto slots = make_shared<const vector<uint32_t>>(view.search(first.empty() ? string_view("ALL") : first, second));
+      size_t firstResult, lastResult;
+      pageBounds(slots->size(), page, firstResult, lastResult);
+      if (firstResult == lastResult)
+      {
+        return replyWith(304, "No classes found!");
+      }
+      if (page.number == 0 && slots->size() > STREAM_MIN_COURSES)
+      {
+        streamCourseSummaries(session, view, opcode, std::move(slots));
+        return 1;
+      }
+      reply.u16(250);
+      reply.u8(opcode);
+      if (page.number > 0)
+      {
+        reply.u32(slots->size());
+      }
+      putCourseSummaries(reply, view, *slots, firstResult, lastResult);
+      break;
     }
-    else if (message == "VIEWGRADES")
+    case Opcode::Show:
     {
-      send_back(pid, "304 NO CONTENT. No grades found.");
-      return 1;
+      if (slot == -1)
+      {
+        return replyWith(404, "No Class Found!");
+      }
+      const CourseTable &table = view.table();
+      string_view strings[] = {table.course_code(slot), table.title(slot), table.subject(slot), table.instructor(slot)};
+      reply.u16(250);
+      reply.u8(opcode);
+      reply.i32(view.seats_available(slot));
+      reply.i32(table.capacity(slot));
+      for (string_view &field : strings)
+      {
+        field = field.substr(0, UINT16_MAX);
+        reply.u16(field.size());
+      }
+      reply.u16(table.prerequisite_count(slot));
+      reply.u16(0);
+      reply.u32(table.description(slot).size());
+      for (string_view field : strings)
+      {
+        reply.bytes(field);
+      }
+      reply.bytes(table.description(slot));
+      for (size_t i = 0; i < table.prerequisite_count(slot); i++)
+      {
+        reply.string(table.prerequisite(slot, i));
+      }
+      break;
     }
-    else
+    case Opcode::Availability:
+      if (slot == -1)
+      {
+        return replyWith(404, "No Class Found!");
+      }
+      reply.u16(250);
+      reply.u8(opcode);
+      reply.i32(view.seats_available(slot));
+      reply.i32(view.table().capacity(slot));
+      break;
+    case Opcode::Prereqs:
     {
-      send_back(pid, "400 BAD REQUEST");
+      if (slot == -1)
+      {
+        return replyWith(404, "No Class Found!");
+      }
+      // Cached per catalog version like SHOW <code> prereqs, so the graph is only walked on a miss
+      send_cached(session, cache, view, cacheKey(session, "BINARY PREREQS", first, ""), [&](CachedResponse::Builder &output)
+                  {
+                    const PrerequisiteGraph &graph = view.prerequisites();
+                    reply.u16(250);
+                    reply.u8(opcode);
+                    reply.u8((graph.blocked_by_cycle(slot) ? 1 : 0) | (graph.incomplete(slot) ? 2 : 0));
+                    vector<uint32_t> chain = graph.chain(slot);
+                    reply.u32(chain.size());
+                    for (uint32_t before : chain)
+                    {
+                      reply.string(view.table().course_code(before));
+                    }
+                    output.append(reply.finish());
+                    output.frame(); });
       return 1;
     }
-    send_back(pid, "400 BAD REQUEST");
+    case Opcode::Enroll:
+      if (slot == -1)
+      {
+        return replyWith(404, "NOT FOUND. Course Not Found.");
+      }
+      if (!view.prerequisites().eligible(slot, view.course_set(students.enrollments(session.student, session.arena.resource()))))
+      {
+        return replyWith(403, "FORBIDDEN. Prerequisites not met.");
+      }
+      switch (registrar.enroll(session.student, code, view.seats(slot)))
+      {
+      case Registrar::Result::Ok:
+        return replyWith(250, "ENROLLMENT SUCCESSFUL.");
+      case Registrar::Result::AlreadyEnrolled:
+        return replyWith(403, "FORBIDDEN. Already enrolled in course.");
+      case Registrar::Result::CourseFull:
+        return replyWith(403, "FORBIDDEN. Course is full.");
+      default:
+        return replyWith(500, "INTERNAL SERVER ERROR");
+      }
+    case Opcode::Drop:
+      switch (registrar.drop(session.student, code))
+      {
+      case Registrar::Result::Ok:
+        return replyWith(250, "Dropped course.");
+      case Registrar::Result::NotEnrolled:
+        return replyWith(404, "NOT FOUND. Class not found in enrollment history.");
+      default:
+        return replyWith(500, "INTERNAL SERVER ERROR");
+      }
+    case Opcode::MyCourses:
+    {
+      auto enrolled = students.enrollments(session.student, session.arena.resource());
+      if (enrolled.empty())
+      {
+        return replyWith(304, "NO CONTENT you haven't enrolled in any classes!");
+      }
+      reply.u16(250);
+      reply.u8(opcode);
+      reply.u32(enrolled.size());
+      for (const auto &course : enrolled)
+      {
+        reply.string(course);
+      }
+      break;
+    }
+    case Opcode::Eligible:
+    {
+      vector<uint32_t> slots = view.prerequisites().eligible_courses(view.course_set(students.enrollments(session.student, session.arena.resource())));
+      if (slots.empty())
+      {
+        return replyWith(304, "No eligible courses found!");
+      }
+      reply.u16(250);
+      reply.u8(opcode);
+      putCourseSummaries(reply, view, slots);
+      break;
+    }
+    default:
+      return replyWith(400, "BAD REQUEST");
+    }
+    session.out.push(reply.finish());
     return 1;
   }
   catch (...)
   {
-    send_back(pid, "500 INTERNAL SERVER ERROR");
-    return 1;
+    reply = FrameWriter();
+    return replyWith(500, "INTERNAL SERVER ERROR");
   }
 }
 
-// Function to handle a single client connection in its own thread
-void handle_client(int pid, struct sockaddr_storage their_addr)
+string peer_address(struct sockaddr_storage &their_addr)
 {
   // A temporary buffer for the client's IP address string
   char s[INET6_ADDRSTRLEN];
   inet_ntop(their_addr.ss_family, get_in_addr((struct sockaddr *)&their_addr), s, sizeof s);
-  std::cout << "server: got connection from " << s << std::endl;
-  int numbytes;
-  bool initalized = false;
+  return s;
+}
 
-  char buf[MAXDATASIZE];
-  string mode = "NO MODE";
+// Handles one message from a client, whichever I/O mode delivered it. Returns 0 to close the connection.
+int process_message(Session &session, const string &message_string, Catalog &catalog, Registrar &registrar, ResponseCache &cache)
+{
+  // The command's temporaries are freed together once it has been handled
+  RequestScope scope(session.arena);
+  if (session.binary.load(std::memory_order_relaxed))
+  {
+    printf("server: received a %zu byte frame\n", message_string.size());
+    return binary_message_handler(session, message_string, catalog, registrar, cache);
+  }
+  if (message_string == LineBuffer::TOO_LONG)
+  {
+    // Only the head of the line was seen; running a cut-off command could act on the wrong argument
+    printf("server: rejected an over-long line\n");
+    send_back(session, "400 LINE TOO LONG");
+    return 1;
+  }
+  printf("server: received '%s'\n", message_string.c_str());
+  if (!session.initialized)
+  {
+    string_view arguments = message_string;
+    if (next_word(arguments) == "IAM")
+    {
+      session.initialized = true;
+      string name(arguments);
+      string first_name = name;
+      // Enrollments are read from the student store, so they follow the student across connections and restarts; so does the last mode
+      session.student = name;
+      string preferredMode = registrar.students().mode(name);
+      if (!preferredMode.empty())
+      {
+        session.mode = parse_mode(preferredMode);
+      }
+      send_back(session, "200 Welcome " + first_name + "@" + session.peer);
+      return 1;
+    }
+    else
+    {
 
-  vector<Course> courses = load_courses_from_db("courses.db");
-  vector<string> enrollmentHistory = {};
+      if (parse_command(message_string).verb != Verb::Unknown)
+      {
+        send_back(session, "403 Bad sequence of commands. Must sign in first!");
+        return 1;
+      }
+      else
+      {
+        send_back(session, "400 Please Sign-In first!");
+        return 1;
+      }
+    }
+  }
+  return message_handler(session, message_string, catalog, registrar, cache);
+}
 
-  while (true)
+// Function to handle a single client connection in its own thread
+void handle_client(int pid, struct sockaddr_storage their_addr, Catalog &catalog, Registrar &registrar, ResponseCache &cache)
+{
+  Session session;
+  session.fd = pid;
+  session.peer = peer_address(their_addr);
+  std::cout << "server: got connection from " << session.peer << std::endl;
+  int numbytes;
+
+  // Every complete line is processed in order; a partial tail waits for the next recv
+  LineBuffer input;
+  string message_string;
+  bool open = true;
+
+  while (open)
   {
-    numbytes = recv(pid, buf, MAXDATASIZE - 1, 0);
+    numbytes = recv(pid, input.prepare(MAXDATASIZE), MAXDATASIZE, 0);
     if (numbytes == 0)
     {
       // client closed
@@ -428,45 +902,18 @@ void handle_client(int pid, struct sockaddr_storage their_addr)
       perror("recv");
       break;
     }
-    buf[numbytes] = '\0';
+    input.commit(numbytes);
 
-    buf[strcspn(buf, "\r\n")] = '\0'; // Strip newline characters
-    string message_string = buf;
-    printf("server: received '%s'\n", buf);
-    if (!initalized)
+    while (next_message(input, session, message_string))
     {
-      if (message_string.find("IAM") != string::npos)
+      if (process_message(session, message_string, catalog, registrar, cache) == 0)
       {
-        initalized = true;
-        string name = message_string.substr(message_string.find(" ") + 1);
-        string first_name;
-        if (name.find(" ") != string::npos)
-        {
-          first_name = name;
-        }
-        else
-        {
-          first_name = name.substr(0, name.find(" "));
-        }
-        send_back(pid, "200 Welcome " + first_name + "@" + s);
-        continue;
-      }
-      else
-      {
-
-        if (isOption(buf))
-        {
-          send_back(pid, "403 Bad sequence of commands. Must sign in first!");
-          continue;
-        }
-        else
-        {
-          send_back(pid, "400 Please Sign-In first!");
-          continue;
-        }
+        open = false;
+        break;
       }
     }
-    if (message_handler(pid, message_string, mode, courses, enrollmentHistory) == 0)
+    // Blocking socket: this only returns once every reply is written
+    if (session.out.flush(pid) == OutputQueue::FlushResult::Error)
     {
       break;
     }
@@ -476,7 +923,7 @@ void handle_client(int pid, struct sockaddr_storage their_addr)
 
   // Close the socket for this connection
   close(pid);
-  std::cout << "server: connection with " << s << " closed." << std::endl;
+  std::cout << "server: connection with " << session.peer << " closed." << std::endl;
 }
 
 map<string, string> read_config_file(string fileName)
@@ -493,7 +940,7 @@ map<string, string> read_config_file(string fileName)
   return configMap;
 }
 
-int main(int argumentCount, char *argumentArray[])
+int main(int, char *argumentArray[])
 {
   int sockfd, new_fd;
   struct addrinfo hints, *servinfo, *p;
@@ -504,8 +951,47 @@ int main(int argumentCount, char *argumentArray[])
 
   std::map<string, string> configMap = read_config_file(argumentArray[1]);
 
+  // A client that disconnects mid-reply must not kill the server with SIGPIPE
+  signal(SIGPIPE, SIG_IGN);
+  // SIGHUP reloads the catalog; block it before any thread starts so only the watcher sees it
+  CatalogWatcher::block_reload_signal();
+
   const char *PORT = configMap["PORT"].c_str();
 
+  // The catalog is loaded once and shared by every connection; LOAD_THREADS=0 (the default) parses on every core
+  Catalog catalog;
+  unsigned loadThreads = configMap.count("LOAD_THREADS") ? stoi(configMap["LOAD_THREADS"]) : 0;
+  if (!catalog.load("courses.db", loadThreads))
+  {
+    fprintf(stderr, "server: no courses loaded from courses.db\n");
+    exit(1);
+  }
+  // Students are kept in STUDENT_SHARDS independently locked shards. WAL_FILE makes ENROLL and DROP durable;
+  // replaying it restores seats and every student's enrollments.
+  // Every CHECKPOINT_INTERVAL_S seconds (0 = never) the log is folded into a checkpoint so replay stays short
+  Registrar registrar(catalog, configMap.count("STUDENT_SHARDS") ? stoul(configMap["STUDENT_SHARDS"]) : 0);
+  if (configMap.count("WAL_FILE") && !configMap["WAL_FILE"].empty())
+  {
+    double windowMs = configMap.count("WAL_COMMIT_WINDOW_MS") ? stod(configMap["WAL_COMMIT_WINDOW_MS"]) : 2;
+    long checkpointSeconds = configMap.count("CHECKPOINT_INTERVAL_S") ? stol(configMap["CHECKPOINT_INTERVAL_S"]) : 60;
+    string error;
+    if (!registrar.open_log(configMap["WAL_FILE"], std::chrono::microseconds(static_cast<long>(windowMs * 1000)), std::chrono::seconds(checkpointSeconds), error))
+    {
+      fprintf(stderr, "server: cannot open enrollment log %s: %s\n", configMap["WAL_FILE"].c_str(), error.c_str());
+      exit(1);
+    }
+  }
+
+  // Rendered LIST, SEARCH and SHOW replies are shared across connections until the catalog is reloaded;
+  // RESPONSE_CACHE_ENTRIES=0 turns the cache off
+  size_t cacheShards = configMap.count("RESPONSE_CACHE_SHARDS") ? stoul(configMap["RESPONSE_CACHE_SHARDS"]) : 0;
+  size_t cacheEntries = configMap.count("RESPONSE_CACHE_ENTRIES") ? stoul(configMap["RESPONSE_CACHE_ENTRIES"]) : 1024;
+  ResponseCache cache(cacheShards, cacheEntries);
+
+  // Reload on SIGHUP, and on any change to courses.db or courses.snap unless WATCH_DB=0
+  bool watchDb = !configMap.count("WATCH_DB") || configMap["WATCH_DB"] != "0";
+  CatalogWatcher watcher(catalog, "courses.db", loadThreads, watchDb);
+
   memset(&hints, 0, sizeof hints);
   hints.ai_family = AF_INET;
   hints.ai_socktype = SOCK_STREAM;
@@ -552,6 +1038,26 @@ int main(int argumentCount, char *argumentArray[])
   }
   std::cout << "server: waiting for connections..." << std::endl;
 
+  // IO_MODE=epoll multiplexes every client over a few reactor threads,
+  // anything else keeps the original thread-per-client model
+  // WORKER_THREADS > 0 moves command execution off the reactors onto a work-stealing pool
+  std::unique_ptr<ThreadPool> workers;
+  std::unique_ptr<EventLoop> eventLoop;
+  if (configMap["IO_MODE"] == "epoll")
+  {
+    int reactorThreads = configMap.count("REACTOR_THREADS") ? stoi(configMap["REACTOR_THREADS"]) : 2;
+    int workerThreads = configMap.count("WORKER_THREADS") ? stoi(configMap["WORKER_THREADS"]) : 0;
+    if (workerThreads > 0)
+    {
+      workers = std::make_unique<ThreadPool>(workerThreads);
+    }
+    eventLoop = std::make_unique<EventLoop>(
+        reactorThreads, [&catalog, &registrar, &cache](Session &session, const string &message)
+        { return process_message(session, message, catalog, registrar, cache); },
+        workers.get());
+    std::cout << "server: epoll mode with " << reactorThreads << " reactor thread(s) and " << workerThreads << " worker thread(s)" << std::endl;
+  }
+
   while (true)
   {
     sin_size = sizeof their_addr;
@@ -563,9 +1069,17 @@ int main(int argumentCount, char *argumentArray[])
       continue;
     }
 
+    if (eventLoop)
+    {
+      string peer = peer_address(their_addr);
+      std::cout << "server: got connection from " << peer << std::endl;
+      eventLoop->add_connection(new_fd, peer);
+      continue;
+    }
+
     // Create a new thread to handle the accepted connection
     // std::jthread automatically joins upon destruction
-    std::jthread(handle_client, new_fd, their_addr).detach();
+    std::jthread(handle_client, new_fd, their_addr, std::ref(catalog), std::ref(registrar), std::ref(cache)).detach();
   }
 
   // The main loop will never exit, so this is unreachable.
@@ -0,0 +1,38 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <atomic>
+#include <string>
+#include "command_parser.h"
+#include "line_buffer.h"
+#include "output_queue.h"
+#include "request_arena.h"
+
+/**
+ * @struct Session
+ * @brief The state of one connected client, independent of how its socket is driven.
+ *
+ * Both the thread-per-client loop and the epoll event loop keep one Session per
+ * socket and hand it to the command handlers in server.cpp.
+ */
+struct Session
+{
+    int fd = -1;
+    std::string peer;        // The client's IP address, used in the welcome message
+    bool initialized = false; // Set once the client has signed in with IAM
+    std::string student;      // The name given with IAM, which keys the student's record in the StudentStore
+    Mode mode = Mode::None;
+    std::atomic<bool> binary{false}; // Switched on by BINARY; read by the thread that splits the input
+    OutputQueue out; // Replies queued by send_back until the I/O path writes them
+    RequestArena arena; // Temporaries of the command being handled, reset after each one
+};
+
+/**
+ * @brief Takes the next command out of a connection's input: a line, or a frame once the session speaks the binary protocol.
+ */
+inline bool next_message(LineBuffer &input, const Session &session, std::string &message)
+{
+    return session.binary.load(std::memory_order_acquire) ? input.next_frame(message) : input.next_line(message);
+}
+
+#endif // SESSION_H
@@ -0,0 +1,105 @@
+/*
+ * STUDENT STORE
+ * -------------
+ * Description: Sharded, per-student enrollments and mode preferences shared by every connection.
+ */
+#include "student_store.h"
+#include <algorithm>
+#include <functional>
+
+static const size_t DEFAULT_SHARDS = 64;
+
+StudentStore::StudentStore(size_t shards)
+    : shard_count_(shards != 0 ? shards : DEFAULT_SHARDS), shards_(std::make_unique<Shard[]>(shard_count_))
+{
+}
+
+StudentStore::Shard &StudentStore::shard(const std::string &student) const
+{
+    return shards_[std::hash<std::string>()(student) % shard_count_];
+}
+
+bool StudentStore::enroll(const std::string &student, std::string_view course_code)
+{
+    Shard &owner = shard(student);
+    std::lock_guard guard(owner.lock);
+    std::vector<std::string> &courses = owner.students[student].enrollments;
+    if (std::find(courses.begin(), courses.end(), course_code) != courses.end())
+    {
+        return false;
+    }
+    courses.emplace_back(course_code);
+    return true;
+}
+
+bool StudentStore::drop(const std::string &student, std::string_view course_code, size_t *position)
+{
+    Shard &owner = shard(student);
+    std::lock_guard guard(owner.lock);
+    auto record = owner.students.find(student);
+    if (record == owner.students.end())
+    {
+        return false;
+    }
+    std::vector<std::string> &courses = record->second.enrollments;
+    auto found = std::find(courses.begin(), courses.end(), course_code);
+    if (found == courses.end())
+    {
+        return false;
+    }
+    if (position)
+    {
+        *position = found - courses.begin();
+    }
+    courses.erase(found);
+    return true;
+}
+
+bool StudentStore::restore(const std::string &student, std::string_view course_code, size_t position)
+{
+    Shard &owner = shard(student);
+    std::lock_guard guard(owner.lock);
+    std::vector<std::string> &courses = owner.students[student].enrollments;
+    if (std::find(courses.begin(), courses.end(), course_code) != courses.end())
+    {
+        return false;
+    }
+    courses.emplace(courses.begin() + std::min(position, courses.size()), course_code);
+    return true;
+}
+
+std::vector<std::string> StudentStore::enrollments(const std::string &student) const
+{
+    const Shard &owner = shard(student);
+    std::lock_guard guard(owner.lock);
+    auto record = owner.students.find(student);
+    return record != owner.students.end() ? record->second.enrollments : std::vector<std::string>();
+}
+
+std::pmr::vector<std::pmr::string> StudentStore::enrollments(const std::string &student, std::pmr::memory_resource *memory) const
+{
+    std::pmr::vector<std::pmr::string> courses(memory);
+    const Shard &owner = shard(student);
+    std::lock_guard guard(owner.lock);
+    auto record = owner.students.find(student);
+    if (record != owner.students.end())
+    {
+        courses.assign(record->second.enrollments.begin(), record->second.enrollments.end());
+    }
+    return courses;
+}
+
+std::string StudentStore::mode(const std::string &student) const
+{
+    const Shard &owner = shard(student);
+    std::lock_guard guard(owner.lock);
+    auto record = owner.students.find(student);
+    return record != owner.students.end() ? record->second.mode : std::string();
+}
+
+void StudentStore::set_mode(const std::string &student, const std::string &mode)
+{
+    Shard &owner = shard(student);
+    std::lock_guard guard(owner.lock);
+    owner.students[student].mode = mode;
+}
@@ -0,0 +1,90 @@
+#ifndef STUDENT_STORE_H
+#define STUDENT_STORE_H
+
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @struct StudentRecord
+ * @brief Everything the server remembers about one student, whichever connection they use.
+ */
+struct StudentRecord
+{
+    std::vector<std::string> enrollments; // Course codes, in enrollment order
+    std::string mode;                     // The mode last switched to, or empty if none yet
+};
+
+/**
+ * @class StudentStore
+ * @brief Concurrent per-student state, keyed by the name given with IAM.
+ *
+ * Students are spread over independently locked shards by a hash of their name,
+ * so two sessions only contend when their students share a shard. With a few
+ * shards per concurrent student the chance of that stays flat as the number of
+ * students grows. Every operation locks exactly one shard, which also makes
+ * enroll() and drop() atomic when one student is signed in on two connections.
+ */
+class StudentStore
+{
+public:
+    /**
+     * @param shards The number of shards; 0 picks a default of 64.
+     */
+    explicit StudentStore(size_t shards = 0);
+
+    /**
+     * @brief Adds a course to a student's enrollments.
+     * @return false if the student was already enrolled in it.
+     */
+    bool enroll(const std::string &student, std::string_view course_code);
+
+    /**
+     * @brief Removes a course from a student's enrollments.
+     * @param position If given, set to where the course was in the enrollments, for restore().
+     * @return false if the student was not enrolled in it.
+     */
+    bool drop(const std::string &student, std::string_view course_code, size_t *position = nullptr);
+
+    /**
+     * @brief Puts a dropped course back where drop() found it, so the enrollment order is unchanged.
+     * @return false if the student is enrolled in it again already.
+     */
+    bool restore(const std::string &student, std::string_view course_code, size_t position);
+
+    /**
+     * @brief A copy of a student's enrollments, in enrollment order.
+     */
+    std::vector<std::string> enrollments(const std::string &student) const;
+
+    /**
+     * @brief A copy of a student's enrollments allocated from a command's arena.
+     */
+    std::pmr::vector<std::pmr::string> enrollments(const std::string &student, std::pmr::memory_resource *memory) const;
+
+    /**
+     * @brief The mode a student last switched to, or an empty string.
+     */
+    std::string mode(const std::string &student) const;
+    void set_mode(const std::string &student, const std::string &mode);
+
+    size_t shard_count() const { return shard_count_; }
+
+private:
+    struct alignas(64) Shard
+    {
+        mutable std::mutex lock;
+        std::unordered_map<std::string, StudentRecord> students;
+    };
+
+    Shard &shard(const std::string &student) const;
+
+    size_t shard_count_;
+    std::unique_ptr<Shard[]> shards_;
+};
+
+#endif // STUDENT_STORE_H
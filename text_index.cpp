@@ -0,0 +1,142 @@
+/*
+ * TEXT INDEX
+ * ----------
+ * Description: Inverted word index behind the title, description and keyword SEARCH filters.
+ */
+#include "text_index.h"
+#include <algorithm>
+#include <cctype>
+#include <unordered_map>
+
+// Calls emit(word, prefix) for every word in text; prefix is set when the word is followed by '*'
+template <typename Emit>
+static void for_each_word(std::string_view text, Emit emit)
+{
+    std::string word;
+    for (size_t i = 0; i <= text.size(); i++)
+    {
+        unsigned char c = i < text.size() ? text[i] : ' ';
+        if (std::isalnum(c))
+        {
+            word += static_cast<char>(std::tolower(c));
+            continue;
+        }
+        if (!word.empty())
+        {
+            emit(word, c == '*');
+            word.clear();
+        }
+    }
+}
+
+std::vector<std::string> TextIndex::tokenize(std::string_view text)
+{
+    std::vector<std::string> words;
+    for_each_word(text, [&](const std::string &word, bool)
+                  { words.push_back(word); });
+    return words;
+}
+
+void TextIndex::build(const CourseTable &table)
+{
+    std::string_view (CourseTable::*columns[FIELD_COUNT])(size_t) const = {&CourseTable::title, &CourseTable::subject, &CourseTable::instructor, &CourseTable::description};
+
+    for (int field = 0; field < FIELD_COUNT; field++)
+    {
+        // Slots are visited in order, so each posting list comes out sorted
+        std::unordered_map<std::string, std::vector<uint32_t>> postings;
+        for (size_t slot = 0; slot < table.size(); slot++)
+        {
+            for_each_word((table.*columns[field])(slot), [&](const std::string &word, bool)
+                          {
+                              std::vector<uint32_t> &list = postings[word];
+                              if (list.empty() || list.back() != slot)
+                              {
+                                  list.push_back(static_cast<uint32_t>(slot));
+                              } });
+        }
+
+        Dictionary &dictionary = fields_[field];
+        dictionary = Dictionary();
+        dictionary.words.reserve(postings.size());
+        for (const auto &entry : postings)
+        {
+            dictionary.words.push_back(entry.first);
+        }
+        std::sort(dictionary.words.begin(), dictionary.words.end());
+
+        dictionary.offsets.reserve(dictionary.words.size() + 1);
+        for (const std::string &word : dictionary.words)
+        {
+            dictionary.offsets.push_back(static_cast<uint32_t>(dictionary.postings.size()));
+            const std::vector<uint32_t> &list = postings[word];
+            dictionary.postings.insert(dictionary.postings.end(), list.begin(), list.end());
+        }
+        dictionary.offsets.push_back(static_cast<uint32_t>(dictionary.postings.size()));
+    }
+}
+
+void TextIndex::collect(const Dictionary &dictionary, std::string_view word, bool prefix, std::vector<uint32_t> &slots) const
+{
+    auto first = std::lower_bound(dictionary.words.begin(), dictionary.words.end(), word);
+    auto last = first;
+    if (prefix)
+    {
+        while (last != dictionary.words.end() && std::string_view(*last).substr(0, word.size()) == word)
+        {
+            ++last;
+        }
+    }
+    else if (last != dictionary.words.end() && *last == word)
+    {
+        ++last;
+    }
+
+    for (auto it = first; it != last; ++it)
+    {
+        size_t i = it - dictionary.words.begin();
+        slots.insert(slots.end(), dictionary.postings.begin() + dictionary.offsets[i], dictionary.postings.begin() + dictionary.offsets[i + 1]);
+    }
+}
+
+std::vector<uint32_t> TextIndex::query(std::string_view text, unsigned fields) const
+{
+    // One sorted slot list per term: the union of its postings over the requested fields
+    std::vector<std::vector<uint32_t>> terms;
+    for_each_word(text, [&](const std::string &word, bool prefix)
+                  {
+                      std::vector<uint32_t> slots;
+                      int sources = 0;
+                      for (int field = 0; field < FIELD_COUNT; field++)
+                      {
+                          if (fields & (1u << field))
+                          {
+                              collect(fields_[field], word, prefix, slots);
+                              sources++;
+                          }
+                      }
+                      if (prefix || sources > 1)
+                      {
+                          std::sort(slots.begin(), slots.end());
+                          slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+                      }
+                      terms.push_back(std::move(slots)); });
+
+    if (terms.empty())
+    {
+        return {};
+    }
+
+    // Intersect starting from the shortest list so the working set only shrinks
+    std::sort(terms.begin(), terms.end(), [](const auto &a, const auto &b)
+              { return a.size() < b.size(); });
+    std::vector<uint32_t> results = std::move(terms[0]);
+    std::vector<uint32_t> scratch;
+    for (size_t i = 1; i < terms.size() && !results.empty(); i++)
+    {
+        scratch.clear();
+        std::set_intersection(results.begin(), results.end(), terms[i].begin(), terms[i].end(), std::back_inserter(scratch));
+        results.swap(scratch);
+    }
+    return results;
+}
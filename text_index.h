@@ -0,0 +1,67 @@
+#ifndef TEXT_INDEX_H
+#define TEXT_INDEX_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "p1_helper.h"
+
+/**
+ * @class TextIndex
+ * @brief An inverted index over the words of each course's title, subject, instructor and description.
+ *
+ * Every field has its own sorted word dictionary, and every word points at a
+ * posting list: the sorted slots of the courses whose field contains that word.
+ * A query intersects the posting lists of its terms, so its cost depends on how
+ * many courses match rather than on the size of the catalog.
+ *
+ * Words are runs of ASCII letters and digits, compared case-insensitively.
+ */
+class TextIndex
+{
+public:
+    enum Field
+    {
+        TITLE,
+        SUBJECT,
+        INSTRUCTOR,
+        DESCRIPTION,
+        FIELD_COUNT
+    };
+
+    // Bit masks for query(): one bit per Field
+    static constexpr unsigned ALL_FIELDS = (1u << FIELD_COUNT) - 1;
+
+    /**
+     * @brief Builds the index for a course table, replacing any previous contents.
+     */
+    void build(const CourseTable &table);
+
+    /**
+     * @brief Finds the courses that contain every term of a query.
+     * @param text The query: one or more words, a word ending in '*' matches any word with that prefix.
+     * @param fields The fields to look in, as a mask of (1 << Field) bits.
+     * @return The matching slots in catalog order; empty if the query has no words.
+     */
+    std::vector<uint32_t> query(std::string_view text, unsigned fields) const;
+
+    /**
+     * @brief Splits text into the lowercase words the index is built from.
+     */
+    static std::vector<std::string> tokenize(std::string_view text);
+
+private:
+    struct Dictionary
+    {
+        std::vector<std::string> words;   // Sorted, distinct
+        std::vector<uint32_t> offsets;    // Postings of words[i] are postings[offsets[i] .. offsets[i + 1])
+        std::vector<uint32_t> postings;   // Sorted slots, one run per word
+    };
+
+    void collect(const Dictionary &dictionary, std::string_view word, bool prefix, std::vector<uint32_t> &slots) const;
+
+    Dictionary fields_[FIELD_COUNT];
+};
+
+#endif // TEXT_INDEX_H
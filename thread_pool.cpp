@@ -0,0 +1,112 @@
+/*
+ * THREAD POOL
+ * -----------
+ * Description: A work-stealing worker pool that runs client commands off the I/O threads.
+ */
+#include "thread_pool.h"
+
+// Lets submit() recognise calls made from one of this pool's own workers
+static thread_local ThreadPool *current_pool = nullptr;
+static thread_local size_t current_worker = 0;
+
+ThreadPool::ThreadPool(int threads)
+{
+    if (threads < 1)
+    {
+        threads = 1;
+    }
+    for (int i = 0; i < threads; i++)
+    {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    // Start the threads only once every deque exists, since workers steal from each other
+    for (size_t i = 0; i < workers_.size(); i++)
+    {
+        workers_[i]->thread = std::jthread([this, i]
+                                           { run(i); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard guard(sleep_lock_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto &worker : workers_)
+    {
+        worker->thread.join();
+    }
+}
+
+void ThreadPool::submit(Task task)
+{
+    size_t index = current_pool == this ? current_worker : next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    {
+        std::lock_guard guard(workers_[index]->lock);
+        workers_[index]->tasks.push_back(std::move(task));
+    }
+    queued_.fetch_add(1, std::memory_order_release);
+
+    // Taking the sleep lock orders this wake-up after any worker's predicate check
+    {
+        std::lock_guard guard(sleep_lock_);
+    }
+    wake_.notify_one();
+}
+
+bool ThreadPool::pop_local(size_t index, Task &task)
+{
+    Worker &worker = *workers_[index];
+    std::lock_guard guard(worker.lock);
+    if (worker.tasks.empty())
+    {
+        return false;
+    }
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(size_t thief, Task &task)
+{
+    for (size_t offset = 1; offset < workers_.size(); offset++)
+    {
+        Worker &victim = *workers_[(thief + offset) % workers_.size()];
+        std::unique_lock guard(victim.lock, std::try_to_lock);
+        if (!guard.owns_lock() || victim.tasks.empty())
+        {
+            continue;
+        }
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::run(size_t index)
+{
+    current_pool = this;
+    current_worker = index;
+
+    while (true)
+    {
+        Task task;
+        if (pop_local(index, task) || steal(index, task))
+        {
+            queued_.fetch_sub(1, std::memory_order_acq_rel);
+            task();
+            continue;
+        }
+
+        std::unique_lock guard(sleep_lock_);
+        if (stopping_ && queued_.load(std::memory_order_acquire) == 0)
+        {
+            return;
+        }
+        wake_.wait(guard, [this]
+                   { return stopping_ || queued_.load(std::memory_order_acquire) > 0; });
+    }
+}
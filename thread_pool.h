@@ -0,0 +1,72 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class ThreadPool
+ * @brief A fixed-size pool of worker threads with per-worker deques and work stealing.
+ *
+ * Each worker pops tasks from the back of its own deque (newest first, while its
+ * data is still warm in cache) and, once that runs dry, steals from the front of
+ * the other workers' deques. Tasks submitted from outside the pool are spread
+ * round-robin; tasks submitted by a worker go to that worker's own deque.
+ */
+class ThreadPool
+{
+public:
+    using Task = std::function<void()>;
+
+    /**
+     * @brief Starts the worker threads.
+     * @param threads The number of workers (at least one is started).
+     */
+    explicit ThreadPool(int threads);
+
+    /**
+     * @brief Runs the tasks that are still queued, then joins the workers.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * @brief Queues a task to run on one of the workers.
+     * @param task The task to run.
+     */
+    void submit(Task task);
+
+    /**
+     * @brief The number of worker threads.
+     */
+    size_t size() const { return workers_.size(); }
+
+private:
+    struct Worker
+    {
+        std::mutex lock;
+        std::deque<Task> tasks;
+        std::jthread thread;
+    };
+
+    void run(size_t index);
+    bool pop_local(size_t index, Task &task);
+    bool steal(size_t thief, Task &task);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<size_t> next_worker_{0};
+    std::atomic<size_t> queued_{0};
+    std::mutex sleep_lock_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+};
+
+#endif // THREAD_POOL_H